@@ -3,11 +3,11 @@ INCLUDEPATH += $$PWD
 HEADERS += \
     $$PWD/icon-view-delegate.h \
     $$PWD/icon-view-editor.h \
-    $$PWD/icon-view-index-widget.h \
+    $$PWD/list-view-delegate.h \
     $$PWD/side-bar-delegate.h
 
 SOURCES += \
     $$PWD/icon-view-delegate.cpp \
     $$PWD/icon-view-editor.cpp \
-    $$PWD/icon-view-index-widget.cpp \
+    $$PWD/list-view-delegate.cpp \
     $$PWD/side-bar-delegate.cpp
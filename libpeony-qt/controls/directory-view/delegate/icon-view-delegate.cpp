@@ -7,7 +7,6 @@
 #include "file-operation-manager.h"
 #include "file-rename-operation.h"
 
-#include <QDebug>
 #include <QLabel>
 
 #include <QPainter>
@@ -22,14 +21,14 @@
 #include <QPainter>
 
 #include "icon-view-editor.h"
-#include "icon-view-index-widget.h"
 
 using namespace Peony;
 using namespace Peony::DirectoryView;
 
 IconViewDelegate::IconViewDelegate(QObject *parent) : QStyledItemDelegate (parent)
 {
-
+    //32 MiB, about 700 tiles of default size.
+    m_tiles.setMaxCost(32*1024);
 }
 
 QSize IconViewDelegate::sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const
@@ -49,15 +48,40 @@ QSize IconViewDelegate::sizeHint(const QStyleOptionViewItem &option, const QMode
 }
 
 void IconViewDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    //NOTE: this is the hot path of icon view, do not allocate or log here.
+    auto view = getView();
+
+    //get file info from index
+    auto model = static_cast<FileItemProxyFilterSortModel*>(view->model());
+    auto item = model->itemFromIndex(index);
+    //NOTE: item might be deleted when painting, because we might start a
+    //location change during the painting.
+    if (!item) {
+        QStyleOptionViewItem opt = option;
+        initStyleOption(&opt, index);
+        option.widget->style()->drawControl(QStyle::CE_ItemViewItem, &opt, painter, opt.widget);
+        return;
+    }
+
+    //most of painting are scrolling and hovering, blit the tile if possible.
+    auto uri = item->uri();
+    qreal dpr = painter->device()->devicePixelRatioF();
+    int state = option.state & (QStyle::State_Selected|QStyle::State_MouseOver|QStyle::State_HasFocus|
+                                QStyle::State_Active|QStyle::State_Enabled);
+    auto tile = findTile(uri, option, dpr, state);
+    if (!tile)
+        tile = renderTile(uri, option, index, dpr, state);
+    painter->drawPixmap(option.rect.topLeft(), *tile);
+
+    //the single selected item is painted expanded by view, see paintExpanded().
+}
+
+void IconViewDelegate::paintItem(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const
 {
     //FIXME: how to deal with word wrap correctly?
 
-    auto view = qobject_cast<IconView*>(this->parent());
-    //default painter
-    //QStyledItemDelegate::paint(painter, option, index);
-    QIcon icon = qvariant_cast<QIcon>(index.data(Qt::DecorationRole));
-    //qDebug()<<option.widget->style();
-    qDebug()<<option.widget;
+    auto view = getView();
     QStyleOptionViewItem opt = option;
     initStyleOption(&opt, index);
 
@@ -65,54 +89,167 @@ void IconViewDelegate::paint(QPainter *painter, const QStyleOptionViewItem &opti
 
     style->drawControl(QStyle::CE_ItemViewItem, &opt, painter, opt.widget);
 
-    //get file info from index
     auto model = static_cast<FileItemProxyFilterSortModel*>(view->model());
     auto item = model->itemFromIndex(index);
-    //NOTE: item might be deleted when painting, because we might start a
-    //location change during the painting.
     if (!item) {
         return;
     }
     auto info = item->info();
-    auto rect = view->visualRect(index);
+    auto rect = option.rect;
 
-    painter->save();
     //paint symbolic link emblems
     if (info->isSymbolLink()) {
-        QIcon icon = QIcon::fromTheme("emblem-symbolic-link");
-        //qDebug()<<info->symbolicIconName();
-        icon.paint(painter, rect.x() + rect.width() - 30, rect.y() + 10, 20, 20, Qt::AlignCenter);
+        paintEmblem(painter, SymbolicLink, QRect(rect.x() + rect.width() - 30, rect.y() + 10, 20, 20));
     }
 
     //paint access emblems
 
     //NOTE: we can not query the file attribute in smb:///(samba) and network:///.
-    if (info->uri().startsWith("smb:") || info->uri().startsWith("network:")) {
-        painter->restore();
+    auto uri = info->uri();
+    if (uri.startsWith(QLatin1String("smb:")) || uri.startsWith(QLatin1String("network:"))) {
         return;
     }
 
     if (!info->canRead()) {
-        QIcon icon = QIcon::fromTheme("emblem-unreadable");
-        icon.paint(painter, rect.x() + 10, rect.y() + 10, 20, 20);
+        paintEmblem(painter, Unreadable, QRect(rect.x() + 10, rect.y() + 10, 20, 20));
     } else if (!info->canWrite() && !info->canExecute()){
-        QIcon icon = QIcon::fromTheme("emblem-readonly");
-        icon.paint(painter, rect.x() + 10, rect.y() + 10, 20, 20);
+        paintEmblem(painter, ReadOnly, QRect(rect.x() + 10, rect.y() + 10, 20, 20));
     }
-    painter->restore();
-
-    //single selection, we have to repaint the emblems.
-    bool useIndexWidget = false;
-    if (view->selectedIndexes().count() == 1 && view->selectedIndexes().first() == index) {
-        useIndexWidget = true;
-        if (view->indexWidget(index)) {
-            return;
-        } else if (view->state() != IconView::DragSelectingState) {
-            IconViewIndexWidget *indexWidget = new IconViewIndexWidget(this, option, index, getView());
-            view->setIndexWidget(index, indexWidget);
-            return;
+}
+
+QRect IconViewDelegate::expandedRect(const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    QStyleOptionViewItem opt = option;
+    initStyleOption(&opt, index);
+
+    //measure the wrapped label as the style lays it out.
+    auto style = opt.widget? opt.widget->style(): QApplication::style();
+    int textMargin = style->pixelMetric(QStyle::PM_FocusFrameHMargin, nullptr, opt.widget) + 1;
+    int textWidth = qMax(1, option.rect.width() - 2*textMargin);
+    QRect textRect = opt.fontMetrics.boundingRect(QRect(0, 0, textWidth, 9999),
+                                                  Qt::AlignHCenter|Qt::TextWrapAnywhere, opt.text);
+
+    int height = qMax(option.rect.height(), opt.decorationSize.height() + textRect.height() + 20);
+    return QRect(option.rect.topLeft(), QSize(option.rect.width(), height));
+}
+
+void IconViewDelegate::paintExpanded(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    QStyleOptionViewItem opt = option;
+    opt.features |= QStyleOptionViewItem::WrapText;
+    opt.textElideMode = Qt::ElideNone;
+
+    //cover the items below.
+    painter->fillRect(opt.rect, opt.palette.base());
+    paintItem(painter, opt, index);
+}
+
+const QPixmap *IconViewDelegate::findTile(const QString &uri, const QStyleOptionViewItem &option, qreal dpr, int state) const
+{
+    auto tiles = m_tiles.object(uri);
+    if (!tiles)
+        return nullptr;
+
+    for (const Tile &tile : *tiles) {
+        if (tile.state == state && tile.size == option.rect.size() &&
+                tile.decorationSize == option.decorationSize && qFuzzyCompare(tile.dpr, dpr)) {
+            return &tile.pixmap;
         }
     }
+    return nullptr;
+}
+
+const QPixmap *IconViewDelegate::renderTile(const QString &uri, const QStyleOptionViewItem &option, const QModelIndex &index, qreal dpr, int state) const
+{
+    Tile tile;
+    tile.size = option.rect.size();
+    tile.decorationSize = option.decorationSize;
+    tile.dpr = dpr;
+    tile.state = state;
+    tile.pixmap = QPixmap(tile.size*dpr);
+    tile.pixmap.setDevicePixelRatio(dpr);
+    tile.pixmap.fill(Qt::transparent);
+
+    QStyleOptionViewItem opt = option;
+    opt.rect.moveTo(0, 0);
+    QPainter p(&tile.pixmap);
+    paintItem(&p, opt, index);
+    p.end();
+
+    //QCache::insert() deletes the replaced object, so take the tiles
+    //of other states out first.
+    auto tiles = m_tiles.take(uri);
+    if (!tiles)
+        tiles = new QVector<Tile>;
+    tiles->append(tile);
+
+    int cost = 0;
+    for (const Tile &t : *tiles) {
+        cost += t.pixmap.width()*t.pixmap.height()*4/1024;
+    }
+    //the tile would be deleted at once if it is larger than the cache.
+    if (!m_tiles.insert(uri, tiles, qMax(1, cost))) {
+        m_fallback_tile = tile.pixmap;
+        return &m_fallback_tile;
+    }
+    return &m_tiles.object(uri)->last().pixmap;
+}
+
+void IconViewDelegate::invalidateTiles(const QString &uri)
+{
+    m_tiles.remove(uri);
+}
+
+void IconViewDelegate::clearCache()
+{
+    m_tiles.clear();
+    for (int i = 0; i < EmblemCount; i++) {
+        m_emblem_pixmaps[i] = QPixmap();
+    }
+}
+
+const QPixmap &IconViewDelegate::emblemPixmap(Emblem emblem, int size, qreal dpr) const
+{
+    if (size != m_emblem_size || !qFuzzyCompare(dpr, m_emblem_dpr)) {
+        for (int i = 0; i < EmblemCount; i++) {
+            m_emblem_pixmaps[i] = QPixmap();
+        }
+        m_emblem_size = size;
+        m_emblem_dpr = dpr;
+    }
+
+    QPixmap &pixmap = m_emblem_pixmaps[emblem];
+    if (pixmap.isNull()) {
+        const char *name = nullptr;
+        switch (emblem) {
+        case SymbolicLink:
+            name = "emblem-symbolic-link";
+            break;
+        case Unreadable:
+            name = "emblem-unreadable";
+            break;
+        default:
+            name = "emblem-readonly";
+            break;
+        }
+        pixmap = QIcon::fromTheme(name).pixmap(QSize(size, size)*dpr);
+        pixmap.setDevicePixelRatio(dpr);
+    }
+    return pixmap;
+}
+
+void IconViewDelegate::paintEmblem(QPainter *painter, Emblem emblem, const QRect &rect) const
+{
+    qreal dpr = painter->device()->devicePixelRatioF();
+    const QPixmap &pixmap = emblemPixmap(emblem, rect.width(), dpr);
+    if (pixmap.isNull())
+        return;
+
+    //the theme might not provide an emblem as large as we want.
+    QSize size = pixmap.size()/dpr;
+    QRect target(QPoint(), size);
+    target.moveCenter(rect.center());
+    painter->drawPixmap(target, pixmap);
 }
 
 void IconViewDelegate::setCutFiles(const QModelIndexList &indexes)
@@ -188,12 +325,6 @@ void IconViewDelegate::setModelData(QWidget *editor, QAbstractItemModel *model,
     }
 }
 
-void IconViewDelegate::setIndexWidget(const QModelIndex &index, QWidget *widget) const
-{
-    auto view = qobject_cast<IconView*>(this->parent());
-    view->setIndexWidget(index, widget);
-}
-
 IconView *IconViewDelegate::getView() const
 {
     return qobject_cast<IconView*>(parent());
@@ -2,17 +2,19 @@
 #define ICONVIEWDELEGATE_H
 
 #include <QStyledItemDelegate>
+#include <QPixmap>
+#include <QCache>
+#include <QVector>
 
 namespace Peony {
 
 namespace DirectoryView {
 
 class IconView;
-class IconViewIndexWidget;
 
 class IconViewDelegate : public QStyledItemDelegate
 {
-    friend class IconViewIndexWidget;
+    friend class IconView;
 
     Q_OBJECT
 public:
@@ -22,6 +24,24 @@ public:
 public Q_SLOTS:
     void setCutFiles(const QModelIndexList &indexes);
 
+    /*!
+     * \brief invalidateTiles
+     * \param uri
+     * <br>
+     * Drop the cached tiles of an item, this should be called when the item's
+     * data changed, such as info updated or thumbnail loaded.
+     * </br>
+     */
+    void invalidateTiles(const QString &uri);
+    /*!
+     * \brief clearCache
+     * <br>
+     * Drop all the cached tiles and emblems, this should be called when
+     * the style, palette, font or icon theme changed.
+     * </br>
+     */
+    void clearCache();
+
 protected:
     void paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const override;
     QSize sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const override;
@@ -32,13 +52,80 @@ protected:
     void updateEditorGeometry(QWidget *editor, const QStyleOptionViewItem &option, const QModelIndex &index) const override;
     void setModelData(QWidget *editor, QAbstractItemModel *model, const QModelIndex &index) const override;
 
-    void setIndexWidget(const QModelIndex &index, QWidget *widget) const;
+    /*!
+     * \brief expandedRect
+     * \param option
+     * \param index
+     * \return the rect of item with its whole label, it is as wide as option.rect
+     * and might be higher.
+     */
+    QRect expandedRect(const QStyleOptionViewItem &option, const QModelIndex &index) const;
+    /*!
+     * \brief paintExpanded
+     * \param painter
+     * \param option, the rect should be the expandedRect().
+     * \param index
+     * <br>
+     * Paint an item with its whole label over the items below it. This is used for
+     * the single selected item, it is not cached as a tile.
+     * </br>
+     */
+    void paintExpanded(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const;
+
+    enum Emblem {
+        SymbolicLink,
+        Unreadable,
+        ReadOnly,
+        EmblemCount
+    };
+
+    /*!
+     * \brief emblemPixmap
+     * \param emblem
+     * \param size, logical size of emblem.
+     * \param dpr, device pixel ratio of painting device.
+     * \return the cached emblem pixmap.
+     * <br>
+     * Emblems are painted for many items in each frame, they are loaded
+     * from icon theme once and cached until the size or dpr changed.
+     * </br>
+     */
+    const QPixmap &emblemPixmap(Emblem emblem, int size, qreal dpr) const;
+    void paintEmblem(QPainter *painter, Emblem emblem, const QRect &rect) const;
+
+    /*!
+     * \brief The Tile struct
+     * \details
+     * A tile is the pre-rendered pixmap of an item, including its icon, label,
+     * and emblems. Painting an item which has a tile only costs a blit.
+     */
+    struct Tile {
+        QSize size;
+        QSize decorationSize;
+        qreal dpr = 1;
+        int state = 0;
+        QPixmap pixmap;
+    };
+
+    const QPixmap *findTile(const QString &uri, const QStyleOptionViewItem &option, qreal dpr, int state) const;
+    const QPixmap *renderTile(const QString &uri, const QStyleOptionViewItem &option, const QModelIndex &index, qreal dpr, int state) const;
+    void paintItem(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const;
 
 private:
     QModelIndexList m_cut_indexes;
 
-    QModelIndex m_index_widget_index;
-    QWidget *m_index_widget;
+    mutable QPixmap m_emblem_pixmaps[EmblemCount];
+    mutable int m_emblem_size = 0;
+    mutable qreal m_emblem_dpr = 0;
+
+    /*!
+     * \brief m_tiles
+     * \details
+     * Tiles of an item in different states, keyed by uri. The cost is
+     * the size of tiles in KiB.
+     */
+    mutable QCache<QString, QVector<Tile>> m_tiles;
+    mutable QPixmap m_fallback_tile;
 };
 
 }
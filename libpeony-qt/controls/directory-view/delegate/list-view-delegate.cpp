@@ -0,0 +1,18 @@
+#include "list-view-delegate.h"
+#include "file-item-model.h"
+
+using namespace Peony;
+using namespace Peony::DirectoryView;
+
+ListViewDelegate::ListViewDelegate(QObject *parent) : QStyledItemDelegate(parent)
+{
+
+}
+
+void ListViewDelegate::initStyleOption(QStyleOptionViewItem *option, const QModelIndex &index) const
+{
+    QStyledItemDelegate::initStyleOption(option, index);
+    //FileItemModel centers the file name for icon view.
+    if (index.column() == FileItemModel::FileName)
+        option->displayAlignment = Qt::AlignLeft|Qt::AlignVCenter;
+}
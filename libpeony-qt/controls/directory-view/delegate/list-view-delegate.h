@@ -0,0 +1,33 @@
+#ifndef LISTVIEWDELEGATE_H
+#define LISTVIEWDELEGATE_H
+
+#include <QStyledItemDelegate>
+
+namespace Peony {
+
+namespace DirectoryView {
+
+/*!
+ * \brief The ListViewDelegate class
+ * <br>
+ * ListViewDelegate is the delegate of ListView. It paints the rows as
+ * QStyledItemDelegate does, but aligns the file name to the left. It does
+ * not create any index widget, so that the view could stay smooth with
+ * a huge count of rows.
+ * </br>
+ */
+class ListViewDelegate : public QStyledItemDelegate
+{
+    Q_OBJECT
+public:
+    explicit ListViewDelegate(QObject *parent = nullptr);
+
+protected:
+    void initStyleOption(QStyleOptionViewItem *option, const QModelIndex &index) const override;
+};
+
+}
+
+}
+
+#endif // LISTVIEWDELEGATE_H
@@ -45,7 +45,7 @@ const QStringList DirectoryViewContainer::getBackList()
 const QStringList DirectoryViewContainer::getForwardList()
 {
     QStringList l;
-    for (auto uri : l) {
+    for (auto uri : m_forward_stack) {
         l<<uri;
     }
     return l;
@@ -2,8 +2,10 @@ INCLUDEPATH += $$PWD
 
 HEADERS += \
     $$PWD/icon-view-factory.h \
+    $$PWD/list-view-factory.h \
     $$PWD/directory-view-factory-manager.h
 
 SOURCES += \
     $$PWD/icon-view-factory.cpp \
+    $$PWD/list-view-factory.cpp \
     $$PWD/directory-view-factory-manager.cpp
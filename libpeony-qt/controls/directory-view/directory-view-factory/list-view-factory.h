@@ -0,0 +1,37 @@
+#ifndef LISTVIEWFACTORY_H
+#define LISTVIEWFACTORY_H
+
+#include "directory-view-plugin-iface.h"
+#include <QObject>
+
+namespace Peony {
+
+class ListViewFactory : public QObject, public DirectoryViewPluginIface
+{
+    Q_OBJECT
+public:
+    static ListViewFactory *getInstance();
+
+    //plugin implement
+    QString name() override {return QObject::tr("List View");}
+    PluginType pluginType() override {return PluginType::DirectoryViewPlugin;}
+    QString description() override {return QObject::tr("Show the folder children as rows in a list.");}
+    QIcon icon() override {return QIcon::fromTheme("view-list-symbolic", QIcon::fromTheme("folder"));}
+    void setEnable(bool enable) override {Q_UNUSED(enable)}
+    bool isEnable() override {return true;}
+
+    //directory view plugin implemeny
+    QString viewIdentity() override {return QObject::tr("List View");}
+    QIcon viewIcon() override {return QIcon::fromTheme("view-list-symbolic", QIcon::fromTheme("folder"));}
+    bool supportUri(const QString &uri) override {return !uri.isEmpty();}
+
+    DirectoryViewIface *create() override;
+
+private:
+    explicit ListViewFactory(QObject *parent = nullptr);
+    ~ListViewFactory() override;
+};
+
+}
+
+#endif // LISTVIEWFACTORY_H
@@ -1,6 +1,10 @@
 #include "icon-view.h"
 #include "standard-view-proxy.h"
 #include "file-item.h"
+#include "view-model-cache.h"
+#include "thumbnail-manager.h"
+#include "item-job-scheduler.h"
+#include "file-info.h"
 
 #include "icon-view-delegate.h"
 #include "icon-view-style.h"
@@ -14,8 +18,11 @@
 
 #include <QPainter>
 #include <QPaintEvent>
+#include <QStyleOptionRubberBand>
+#include <QRubberBand>
 
 #include <QApplication>
+#include <QScrollBar>
 
 #include <QDebug>
 
@@ -51,18 +58,37 @@ void IconView::init()
     setSelectionMode(QListView::ExtendedSelection);
     setEditTriggers(QListView::NoEditTriggers);
     setViewMode(QListView::IconMode);
-    setResizeMode(QListView::Adjust);
-    setMovement(QListView::Snap);
+    //the items are laid out in a uniform grid by ourselves, do not let
+    //QListView layout and move them, see doItemsLayout().
+    setResizeMode(QListView::Fixed);
+    setMovement(QListView::Static);
+    setVerticalScrollMode(QListView::ScrollPerPixel);
+    setDragEnabled(true);
+    setDragDropMode(QListView::DragDrop);
+    setDefaultDropAction(Qt::MoveAction);
+    viewport()->setAttribute(Qt::WA_Hover);
     //setWordWrap(true);
 
-    m_model = new FileItemModel(this);
-    m_sort_filter_proxy_model = new FileItemProxyFilterSortModel(m_model);
-    m_sort_filter_proxy_model->setSourceModel(m_model);
+    m_model_cache = new ViewModelCache(this);
 
-    setModel(m_sort_filter_proxy_model);
+    auto model = new FileItemModel(this);
+    auto proxyModel = new FileItemProxyFilterSortModel(model);
+    proxyModel->setSourceModel(model);
+    bindModel(model, proxyModel);
 
     setGridSize(QSize(115, 135));
     setIconSize(QSize(64, 64));
+
+    //throttle rather than debounce, so that the priorities are updated
+    //while scrolling.
+    m_viewport_update_timer.setSingleShot(true);
+    m_viewport_update_timer.setInterval(100);
+    connect(&m_viewport_update_timer, &QTimer::timeout, this, &IconView::updateViewport);
+    connect(verticalScrollBar(), &QScrollBar::valueChanged, this, [=](){
+        if (!m_viewport_update_timer.isActive())
+            m_viewport_update_timer.start();
+    });
+    connect(ThumbnailManager::getInstance(), &ThumbnailManager::thumbnailUpdated, this, &IconView::onThumbnailUpdated);
 }
 
 void IconView::rebindProxy()
@@ -73,27 +99,83 @@ void IconView::rebindProxy()
 
     disconnect();
 
-    connect(m_model, &FileItemModel::updated, [=](){
+    connect(this, &IconView::doubleClicked, [=](const QModelIndex &index){
+        qDebug()<<"double click"<<index.data(FileItemModel::UriRole);
+        Q_EMIT m_proxy->viewDoubleClicked(index.data(FileItemModel::UriRole).toString());
+    });
+
+    bindModelSignals();
+}
+
+void IconView::bindModel(FileItemModel *model, FileItemProxyFilterSortModel *proxyModel)
+{
+    if (m_model) {
+        m_model->disconnect(this);
+        if (m_proxy)
+            m_model->disconnect(m_proxy);
+    }
+
+    m_model = model;
+    m_model->setParent(this);
+    m_sort_filter_proxy_model = proxyModel;
+    m_last_index = QModelIndex();
+    m_single_selected_index = QModelIndex();
+    m_expanded_rect = QRect();
+    m_hover_index = QModelIndex();
+    m_thumbnail_indexes.clear();
+
+    //QAbstractItemView::setModel() will not delete the old selection model.
+    auto oldSelectionModel = selectionModel();
+    setModel(m_sort_filter_proxy_model);
+    if (oldSelectionModel)
+        oldSelectionModel->deleteLater();
+
+    bindModelSignals();
+}
+
+void IconView::bindModelSignals()
+{
+    //this might be called both in binding model and proxy.
+    m_model->disconnect(this);
+    selectionModel()->disconnect(this);
+
+    //the pre-rendered tiles of changed or removed items are out of date.
+    connect(m_model, &FileItemModel::dataChanged, this, &IconView::invalidateTiles);
+    connect(m_model, &FileItemModel::rowsAboutToBeRemoved, this, [=](const QModelIndex &parent, int first, int last){
+        invalidateTiles(m_model->index(first, 0, parent), m_model->index(last, 0, parent));
+    });
+
+    if (!m_proxy) {
+        return;
+    }
+
+    m_model->disconnect(m_proxy);
+
+    connect(m_model, &FileItemModel::updated, this, [=](){
         m_sort_filter_proxy_model->sort(FileItemModel::FileName);
+        m_viewport_update_timer.start();
     });
 
     connect(m_model, &FileItemModel::findChildrenFinished,
             m_proxy, &DirectoryViewProxyIface::viewDirectoryChanged);
 
-    connect(this, &IconView::doubleClicked, [=](const QModelIndex &index){
-        qDebug()<<"double click"<<index.data(FileItemModel::UriRole);
-        Q_EMIT m_proxy->viewDoubleClicked(index.data(FileItemModel::UriRole).toString());
-    });
-
     //edit trigger
-    connect(this->selectionModel(), &QItemSelectionModel::selectionChanged, [=](const QItemSelection &selection, const QItemSelection &deselection){
-        qDebug()<<"selection changed";
+    connect(this->selectionModel(), &QItemSelectionModel::selectionChanged, this, [=](const QItemSelection &selection, const QItemSelection &deselection){
         auto currentSelections = selection.indexes();
 
-        for (auto index : deselection.indexes()) {
-            this->setIndexWidget(index, nullptr);
+        //a single item is selected if there is only one range with one index.
+        auto selections = this->selectionModel()->selection();
+        if (selections.count() == 1 && selections.first().height() == 1 && selections.first().width() == 1) {
+            m_single_selected_index = selections.first().topLeft();
+        } else {
+            m_single_selected_index = QModelIndex();
         }
 
+        //the selected and deselected items are repainted by view itself,
+        //only the expanded label might be out of their rects.
+        Q_UNUSED(deselection);
+        updateExpandedRect();
+
         Q_EMIT m_proxy->viewSelectionChanged();
         if (currentSelections.count() == 1) {
             m_last_index = currentSelections.first();
@@ -167,6 +249,44 @@ const QString IconView::getDirectoryUri()
 
 void IconView::beginLocationChange()
 {
+    m_pending_scroll_value = -1;
+
+    auto rootUri = m_model->getRootUri();
+    if (rootUri.isNull() || rootUri == m_current_uri) {
+        //first location or refresh, enumerate in current model.
+        m_model->setRootUri(m_current_uri);
+        return;
+    }
+
+    ViewModelCache::Location current;
+    current.model = m_model;
+    current.proxyModel = m_sort_filter_proxy_model;
+    current.scrollValue = verticalScrollBar()->value();
+    current.selections = getSelections();
+
+    auto location = m_model_cache->take(m_current_uri);
+    if (location.model) {
+        bindModel(location.model, location.proxyModel);
+        m_model_cache->retain(rootUri, current);
+
+        m_pending_scroll_value = location.scrollValue;
+        setSelections(location.selections);
+        m_viewport_update_timer.start();
+        if (m_proxy)
+            Q_EMIT m_proxy->viewDirectoryChanged();
+
+        //the watcher has kept the model up to date while it was retained,
+        //revalidate it for the locations which not support monitoring.
+        m_model->revalidate();
+        return;
+    }
+
+    auto model = new FileItemModel(this);
+    auto proxyModel = new FileItemProxyFilterSortModel(model);
+    proxyModel->setSourceModel(model);
+    bindModel(model, proxyModel);
+    m_model_cache->retain(rootUri, current);
+
     m_model->setRootUri(m_current_uri);
 }
 
@@ -196,8 +316,10 @@ void IconView::dragEnterEvent(QDragEnterEvent *e)
 
 void IconView::dragMoveEvent(QDragMoveEvent *e)
 {
+    //NOTE: QListView's icon mode drag and drop works on its own layout items,
+    //which are never created by our grid layout.
     if (this == e->source()) {
-        return QListView::dragMoveEvent(e);
+        return QAbstractItemView::dragMoveEvent(e);
     }
     e->setDropAction(Qt::MoveAction);
     e->accept();
@@ -210,7 +332,7 @@ void IconView::dropEvent(QDropEvent *e)
     qDebug()<<"dropEvent";
     if (e->source() == this) {
         if (indexAt(e->pos()).isValid()) {
-            return QListView::dropEvent(e);
+            return QAbstractItemView::dropEvent(e);
         }
         else {
             return;
@@ -225,19 +347,40 @@ void IconView::dropEvent(QDropEvent *e)
 void IconView::mousePressEvent(QMouseEvent *e)
 {
     QListView::mousePressEvent(e);
+    m_rubber_band_rect = QRect();
+    m_rubber_band_origin = e->pos() + QPoint(horizontalOffset(), verticalOffset());
 
     qDebug()<<m_edit_trigger_timer.isActive()<<m_edit_trigger_timer.interval();
     if (indexAt(e->pos()) == m_last_index && m_last_index.isValid()) {
         if (m_edit_trigger_timer.isActive()) {
-            setIndexWidget(m_last_index, nullptr);
             edit(m_last_index);
         }
     }
 }
 
+void IconView::mouseMoveEvent(QMouseEvent *e)
+{
+    QListView::mouseMoveEvent(e);
+    if (state() != DragSelectingState)
+        return;
+
+    //QListView only draws the rubber band of its own layout.
+    QRect rect = QRect(m_rubber_band_origin, e->pos() + QPoint(horizontalOffset(), verticalOffset())).normalized();
+    auto offset = QPoint(horizontalOffset(), verticalOffset());
+    viewport()->update(m_rubber_band_rect.translated(-offset).adjusted(-1, -1, 1, 1));
+    viewport()->update(rect.translated(-offset).adjusted(-1, -1, 1, 1));
+    m_rubber_band_rect = rect;
+}
+
 void IconView::mouseReleaseEvent(QMouseEvent *e)
 {
     QListView::mouseReleaseEvent(e);
+    if (!m_rubber_band_rect.isNull()) {
+        viewport()->update(m_rubber_band_rect.translated(-horizontalOffset(), -verticalOffset()).adjusted(-1, -1, 1, 1));
+        m_rubber_band_rect = QRect();
+        //the expanded item is hidden while drag selecting.
+        updateExpandedRect();
+    }
     if (!m_edit_trigger_timer.isActive() && indexAt(e->pos()).isValid() && this->selectedIndexes().count() == 1) {
         resetEditTriggerTimer();
     }
@@ -254,19 +397,192 @@ void IconView::resetEditTriggerTimer()
     });
 }
 
+bool IconView::viewportEvent(QEvent *e)
+{
+    switch (e->type()) {
+    case QEvent::HoverMove:
+    case QEvent::HoverEnter: {
+        auto index = indexAt(static_cast<QHoverEvent*>(e)->pos());
+        if (index != m_hover_index) {
+            viewport()->update(visualRect(m_hover_index));
+            m_hover_index = index;
+            viewport()->update(visualRect(m_hover_index));
+        }
+        break;
+    }
+    case QEvent::HoverLeave:
+    case QEvent::Leave:
+        viewport()->update(visualRect(m_hover_index));
+        m_hover_index = QModelIndex();
+        break;
+    default:
+        break;
+    }
+    return QListView::viewportEvent(e);
+}
+
 void IconView::paintEvent(QPaintEvent *e)
 {
     QPainter p(this->viewport());
-    p.fillRect(this->geometry(), this->palette().base());
-    QListView::paintEvent(e);
+    p.fillRect(e->rect(), this->palette().base());
+    if (!model())
+        return;
+
+    //only paint the items intersect with the exposed rect.
+    auto offset = QPoint(horizontalOffset(), verticalOffset());
+    int first, last;
+    if (rowsInContentsRect(e->rect().translated(offset), first, last)) {
+        QStyleOptionViewItem option = viewOptions();
+        auto state = option.state;
+        if (isActiveWindow()) {
+            state |= QStyle::State_Active;
+        } else {
+            option.palette.setCurrentColorGroup(QPalette::Inactive);
+        }
+        auto current = currentIndex();
+        auto root = rootIndex();
+        for (int row = first; row <= last; row++) {
+            auto index = model()->index(row, 0, root);
+            option.rect = itemRect(row).translated(-offset);
+            if (!option.rect.intersects(e->rect()))
+                continue;
+
+            option.state = state;
+            if (selectionModel() && selectionModel()->isSelected(index))
+                option.state |= QStyle::State_Selected;
+            if (index == m_hover_index && this->state() != DragSelectingState)
+                option.state |= QStyle::State_MouseOver;
+            if (index == current && hasFocus())
+                option.state |= QStyle::State_HasFocus;
+            itemDelegate()->paint(&p, option, index);
+        }
+    }
+
+    auto delegate = qobject_cast<IconViewDelegate*>(itemDelegate());
+    if (delegate && isExpandedVisible() && m_expanded_rect.translated(-offset).intersects(e->rect())) {
+        QStyleOptionViewItem option = viewOptions();
+        option.rect = m_expanded_rect.translated(-offset);
+        option.state |= QStyle::State_Selected;
+        if (isActiveWindow()) {
+            option.state |= QStyle::State_Active;
+        } else {
+            option.palette.setCurrentColorGroup(QPalette::Inactive);
+        }
+        if (m_single_selected_index == currentIndex() && hasFocus())
+            option.state |= QStyle::State_HasFocus;
+        delegate->paintExpanded(&p, option, m_single_selected_index);
+    }
+
+    if (!m_rubber_band_rect.isNull()) {
+        QStyleOptionRubberBand opt;
+        opt.initFrom(this);
+        opt.shape = QRubberBand::Rectangle;
+        opt.opaque = false;
+        opt.rect = m_rubber_band_rect.translated(-offset);
+        style()->drawControl(QStyle::CE_RubberBand, &opt, &p, this);
+    }
 }
 
 void IconView::resizeEvent(QResizeEvent *e)
 {
-    //FIXME: first resize is disfluency.
-    //but I have to reset the index widget in view's resize.
+    //the grid layout is computed on demand, resizing only updates the
+    //scroll bars.
     QListView::resizeEvent(e);
-    setIndexWidget(m_last_index, nullptr);
+    m_viewport_update_timer.start();
+}
+
+void IconView::doItemsLayout()
+{
+    //skip QListView's layout, which is linear in the count of items.
+    QAbstractItemView::doItemsLayout();
+}
+
+void IconView::updateGeometries()
+{
+    m_item_size = itemDelegate()->sizeHint(viewOptions(), QModelIndex());
+
+    int count = model()? model()->rowCount(rootIndex()): 0;
+    int columns = gridColumnCount();
+    int rows = (count + columns - 1)/columns;
+    int contentsHeight = rows > 0? rows*gridSize().height() + m_item_offset.y(): 0;
+    int contentsWidth = columns*gridSize().width();
+
+    verticalScrollBar()->setSingleStep(gridSize().height()/3);
+    verticalScrollBar()->setPageStep(viewport()->height());
+    verticalScrollBar()->setRange(0, qMax(0, contentsHeight - viewport()->height()));
+    horizontalScrollBar()->setSingleStep(gridSize().width()/3);
+    horizontalScrollBar()->setPageStep(viewport()->width());
+    horizontalScrollBar()->setRange(0, qMax(0, contentsWidth - viewport()->width()));
+
+    //skip QListView::updateGeometries(), it uses the contents size of its own layout.
+    QAbstractItemView::updateGeometries();
+    updateExpandedRect();
+
+    if (m_pending_scroll_value < 0)
+        return;
+
+    if (verticalScrollBar()->maximum() >= m_pending_scroll_value) {
+        verticalScrollBar()->setValue(m_pending_scroll_value);
+        m_pending_scroll_value = -1;
+    }
+}
+
+void IconView::changeEvent(QEvent *e)
+{
+    QListView::changeEvent(e);
+    switch (e->type()) {
+    case QEvent::StyleChange:
+    case QEvent::PaletteChange:
+    case QEvent::FontChange:
+    case QEvent::ThemeChange: {
+        auto delegate = qobject_cast<IconViewDelegate*>(itemDelegate());
+        if (delegate)
+            delegate->clearCache();
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void IconView::invalidateTiles(const QModelIndex &topLeft, const QModelIndex &bottomRight)
+{
+    auto delegate = qobject_cast<IconViewDelegate*>(itemDelegate());
+    if (!delegate || !topLeft.isValid() || !bottomRight.isValid())
+        return;
+
+    for (int row = topLeft.row(); row <= bottomRight.row(); row++) {
+        auto index = m_model->index(row, 0, topLeft.parent());
+        delegate->invalidateTiles(index.data(FileItemModel::UriRole).toString());
+    }
+
+    //the label of expanded item might be changed.
+    if (m_single_selected_index.isValid())
+        updateExpandedRect();
+}
+
+void IconView::updateExpandedRect()
+{
+    auto offset = QPoint(horizontalOffset(), verticalOffset());
+    if (!m_expanded_rect.isNull())
+        viewport()->update(m_expanded_rect.translated(-offset));
+
+    auto delegate = qobject_cast<IconViewDelegate*>(itemDelegate());
+    if (!delegate || !m_single_selected_index.isValid()) {
+        m_expanded_rect = QRect();
+        return;
+    }
+
+    QStyleOptionViewItem option = viewOptions();
+    option.rect = itemRect(m_single_selected_index.row());
+    m_expanded_rect = delegate->expandedRect(option, m_single_selected_index);
+    viewport()->update(m_expanded_rect.translated(-offset));
+}
+
+bool IconView::isExpandedVisible() const
+{
+    return !m_expanded_rect.isNull() && m_single_selected_index.isValid() &&
+            state() != DragSelectingState && state() != EditingState;
 }
 
 void IconView::setProxy(DirectoryViewProxyIface *proxy)
@@ -278,12 +594,273 @@ void IconView::setProxy(DirectoryViewProxyIface *proxy)
     rebindProxy();
 }
 
+int IconView::gridColumnCount() const
+{
+    int width = gridSize().width();
+    if (width <= 0)
+        return 1;
+    return qMax(1, viewport()->width()/width);
+}
+
+QRect IconView::itemRect(int row) const
+{
+    int columns = gridColumnCount();
+    auto grid = gridSize();
+    QPoint pos((row%columns)*grid.width(), (row/columns)*grid.height());
+    return QRect(pos + m_item_offset, m_item_size);
+}
+
+bool IconView::rowsInContentsRect(const QRect &rect, int &first, int &last) const
+{
+    auto grid = gridSize();
+    if (!model() || grid.isEmpty() || rect.isEmpty())
+        return false;
+
+    int count = model()->rowCount(rootIndex());
+    int columns = gridColumnCount();
+    int firstGridRow = qMax(0, (rect.top() - m_item_offset.y())/grid.height());
+    int lastGridRow = qMax(0, (rect.bottom() - m_item_offset.y())/grid.height());
+    first = firstGridRow*columns;
+    last = qMin(count - 1, (lastGridRow + 1)*columns - 1);
+    return first <= last;
+}
+
 QRect IconView::visualRect(const QModelIndex &index) const
 {
-    auto rect = QListView::visualRect(index);
-    rect.setX(rect.x() + 10);
-    rect.setY(rect.y() + 15);
-    auto size = itemDelegate()->sizeHint(QStyleOptionViewItem(), index);
-    rect.setSize(size);
-    return rect;
+    if (!index.isValid() || index.parent() != rootIndex())
+        return QRect();
+    return itemRect(index.row()).translated(-horizontalOffset(), -verticalOffset());
+}
+
+QModelIndex IconView::indexAt(const QPoint &point) const
+{
+    auto grid = gridSize();
+    if (!model() || grid.isEmpty())
+        return QModelIndex();
+
+    //the expanded item covers the items below it.
+    if (isExpandedVisible() && m_expanded_rect.contains(point + QPoint(horizontalOffset(), verticalOffset())))
+        return m_single_selected_index;
+
+    auto pos = point + QPoint(horizontalOffset(), verticalOffset()) - m_item_offset;
+    if (pos.x() < 0 || pos.y() < 0)
+        return QModelIndex();
+
+    int column = pos.x()/grid.width();
+    int columns = gridColumnCount();
+    if (column >= columns)
+        return QModelIndex();
+
+    int row = pos.y()/grid.height()*columns + column;
+    if (row >= model()->rowCount(rootIndex()))
+        return QModelIndex();
+
+    //the spacing between items does not belong to any item.
+    if (!itemRect(row).contains(pos + m_item_offset))
+        return QModelIndex();
+    return model()->index(row, 0, rootIndex());
+}
+
+void IconView::scrollTo(const QModelIndex &index, ScrollHint hint)
+{
+    if (!index.isValid() || index.parent() != rootIndex())
+        return;
+
+    auto rect = itemRect(index.row());
+    //include the margin above the item.
+    rect.setTop(rect.top() - m_item_offset.y());
+    int value = verticalScrollBar()->value();
+    int height = viewport()->height();
+    switch (hint) {
+    case PositionAtTop:
+        value = rect.top();
+        break;
+    case PositionAtBottom:
+        value = rect.bottom() - height + 1;
+        break;
+    case PositionAtCenter:
+        value = rect.center().y() - height/2;
+        break;
+    case EnsureVisible:
+    default:
+        if (rect.top() < value) {
+            value = rect.top();
+        } else if (rect.bottom() >= value + height) {
+            value = rect.bottom() - height + 1;
+        }
+        break;
+    }
+    verticalScrollBar()->setValue(value);
+}
+
+int IconView::horizontalOffset() const
+{
+    return horizontalScrollBar()->value();
+}
+
+int IconView::verticalOffset() const
+{
+    return verticalScrollBar()->value();
+}
+
+QModelIndex IconView::moveCursor(CursorAction cursorAction, Qt::KeyboardModifiers modifiers)
+{
+    Q_UNUSED(modifiers);
+    if (!model())
+        return QModelIndex();
+
+    int count = model()->rowCount(rootIndex());
+    if (count == 0)
+        return QModelIndex();
+
+    auto current = currentIndex();
+    if (!current.isValid())
+        return model()->index(0, 0, rootIndex());
+
+    int columns = gridColumnCount();
+    int pageRows = qMax(1, viewport()->height()/qMax(1, gridSize().height()));
+    int row = current.row();
+    switch (cursorAction) {
+    case MoveLeft:
+    case MovePrevious:
+        row--;
+        break;
+    case MoveRight:
+    case MoveNext:
+        row++;
+        break;
+    case MoveUp:
+        row -= columns;
+        break;
+    case MoveDown:
+        //move to the last item if there is no item below in last grid row.
+        if (row/columns < (count - 1)/columns)
+            row = qMin(row + columns, count - 1);
+        break;
+    case MovePageUp:
+        row -= pageRows*columns;
+        break;
+    case MovePageDown:
+        row += pageRows*columns;
+        break;
+    case MoveHome:
+        row = 0;
+        break;
+    case MoveEnd:
+        row = count - 1;
+        break;
+    }
+
+    if (row < 0) {
+        row = cursorAction == MovePageUp? current.row()%columns: current.row();
+    } else if (row >= count) {
+        row = cursorAction == MovePageDown? count - 1: current.row();
+    }
+    return model()->index(row, 0, rootIndex());
+}
+
+void IconView::setSelection(const QRect &rect, QItemSelectionModel::SelectionFlags command)
+{
+    if (!selectionModel())
+        return;
+
+    //only the items in the grid rows intersect with the rect are checked.
+    auto contentsRect = rect.normalized().translated(horizontalOffset(), verticalOffset());
+    QItemSelection selection;
+    int first, last;
+    if (rowsInContentsRect(contentsRect, first, last)) {
+        int rangeStart = -1;
+        for (int row = first; row <= last + 1; row++) {
+            bool contained = row <= last && itemRect(row).intersects(contentsRect);
+            if (contained && rangeStart < 0) {
+                rangeStart = row;
+            } else if (!contained && rangeStart >= 0) {
+                selection.select(model()->index(rangeStart, 0, rootIndex()),
+                                 model()->index(row - 1, 0, rootIndex()));
+                rangeStart = -1;
+            }
+        }
+    }
+    selectionModel()->select(selection, command);
+}
+
+QRegion IconView::visualRegionForSelection(const QItemSelection &selection) const
+{
+    //only the visible part of selection need to be updated.
+    QRegion region;
+    int first, last;
+    auto visible = viewport()->rect().translated(horizontalOffset(), verticalOffset());
+    if (!rowsInContentsRect(visible, first, last))
+        return region;
+
+    for (auto range : selection) {
+        if (range.parent() != rootIndex())
+            continue;
+        int top = qMax(first, range.top());
+        int bottom = qMin(last, range.bottom());
+        for (int row = top; row <= bottom; row++) {
+            region += itemRect(row).translated(-horizontalOffset(), -verticalOffset());
+        }
+    }
+    return region;
+}
+
+void IconView::updateViewport()
+{
+    m_thumbnail_indexes.clear();
+
+    if (!m_sort_filter_proxy_model)
+        return;
+
+    //the items are in grid, this only costs the count of the items in band.
+    auto visibleRect = viewport()->rect().translated(horizontalOffset(), verticalOffset());
+    auto bandRect = visibleRect.adjusted(0, -visibleRect.height(), 0, visibleRect.height());
+    int first, last, firstVisible, lastVisible;
+    if (!rowsInContentsRect(bandRect, first, last))
+        return;
+    if (!rowsInContentsRect(visibleRect, firstVisible, lastVisible)) {
+        firstVisible = -1;
+        lastVisible = -2;
+    }
+
+    QStringList visibleUris;
+    QStringList prefetchUris;
+    QStringList thumbnailUris;
+    QStringList prefetchThumbnailUris;
+    for (int row = first; row <= last; row++) {
+        auto index = m_sort_filter_proxy_model->index(row, 0, rootIndex());
+        auto item = m_sort_filter_proxy_model->itemFromIndex(index);
+        if (!item)
+            continue;
+        bool visible = row >= firstVisible && row <= lastVisible;
+        auto uri = item->uri();
+        if (visible) {
+            visibleUris<<uri;
+        } else {
+            prefetchUris<<uri;
+        }
+
+        if (item->info()->isDir() || m_thumbnail_indexes.contains(uri))
+            continue;
+        m_thumbnail_indexes.insert(uri, index);
+        if (visible) {
+            thumbnailUris<<uri;
+        } else {
+            prefetchThumbnailUris<<uri;
+        }
+    }
+
+    ItemJobScheduler::getInstance()->setViewport(this, visibleUris, prefetchUris);
+    ThumbnailManager::getInstance()->requestThumbnails(this, thumbnailUris + prefetchThumbnailUris);
+}
+
+void IconView::onThumbnailUpdated(const QString &uri)
+{
+    auto delegate = qobject_cast<IconViewDelegate*>(itemDelegate());
+    delegate->invalidateTiles(uri);
+
+    auto index = m_thumbnail_indexes.value(uri);
+    if (index.isValid()) {
+        viewport()->update(visualRect(index));
+    }
 }
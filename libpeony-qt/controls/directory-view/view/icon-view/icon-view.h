@@ -7,12 +7,15 @@
 #include "file-item-proxy-filter-sort-model.h"
 #include <QListView>
 #include <QTimer>
+#include <QHash>
+#include <QPersistentModelIndex>
 
 namespace Peony {
 
 namespace DirectoryView {
 
 class IconViewDelegate;
+class ViewModelCache;
 
 class PEONYCORESHARED_EXPORT IconView : public QListView, public DirectoryViewIface
 {
@@ -43,7 +46,10 @@ public:
     //selections
     QStringList getSelections() override;
 
+    //grid layout
     QRect visualRect(const QModelIndex &index) const override;
+    QModelIndex indexAt(const QPoint &point) const override;
+    void scrollTo(const QModelIndex &index, ScrollHint hint = EnsureVisible) override;
 
 public Q_SLOTS:
     //location
@@ -70,24 +76,157 @@ protected:
     void dropEvent(QDropEvent *e) override;
 
     void mousePressEvent(QMouseEvent *e) override;
+    void mouseMoveEvent(QMouseEvent *e) override;
     void mouseReleaseEvent(QMouseEvent *e) override;
+    bool viewportEvent(QEvent *e) override;
 
     void paintEvent(QPaintEvent *e) override;
     void resizeEvent(QResizeEvent *e) override;
 
+    void updateGeometries() override;
+    void changeEvent(QEvent *e) override;
+
+    //grid layout
+    void doItemsLayout() override;
+    int horizontalOffset() const override;
+    int verticalOffset() const override;
+    QModelIndex moveCursor(CursorAction cursorAction, Qt::KeyboardModifiers modifiers) override;
+    void setSelection(const QRect &rect, QItemSelectionModel::SelectionFlags command) override;
+    QRegion visualRegionForSelection(const QItemSelection &selection) const override;
+
+    /*!
+     * \brief gridColumnCount
+     * \return the count of items in a grid row.
+     */
+    int gridColumnCount() const;
+    /*!
+     * \brief itemRect
+     * \param row
+     * \return the rect of item in contents coordinates.
+     */
+    QRect itemRect(int row) const;
+    /*!
+     * \brief rowsInContentsRect
+     * \param rect, a rect in contents coordinates.
+     * \param first, the first row of items whose grid rows intersect the rect.
+     * \param last, the last row of items whose grid rows intersect the rect.
+     * \return false if there is no such row.
+     */
+    bool rowsInContentsRect(const QRect &rect, int &first, int &last) const;
+
+    /*!
+     * \brief updateExpandedRect
+     * <br>
+     * Recompute the expanded rect of single selected item and repaint the
+     * old and new one. It should be called when the selection, the layout
+     * or the item's data changed.
+     * </br>
+     */
+    void updateExpandedRect();
+    bool isExpandedVisible() const;
+
 protected:
     void init();
     void rebindProxy();
+    /*!
+     * \brief bindModel
+     * \param model
+     * \param proxyModel
+     * <br>
+     * Set a new model for view, the signals of previous model and its
+     * selection model will be disconnected. This is used both for a new
+     * created model and a model retained by ViewModelCache.
+     * </br>
+     */
+    void bindModel(FileItemModel *model, FileItemProxyFilterSortModel *proxyModel);
+    void bindModelSignals();
+    void invalidateTiles(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+
+    /*!
+     * \brief updateViewport
+     * <br>
+     * Report the visible items and a prefetch band of one page around them
+     * to ItemJobScheduler, and request their thumbnails. This is triggered
+     * at most once per a short interval while scrolling, resizing or model
+     * updating, the requests of rows which were scrolled away will be
+     * deprioritized or cancelled.
+     * </br>
+     * \see ItemJobScheduler::setViewport(), ThumbnailManager::requestThumbnails().
+     */
+    void updateViewport();
+    void onThumbnailUpdated(const QString &uri);
 
 private:
     QTimer m_edit_trigger_timer;
     QModelIndex m_last_index;
+    /*!
+     * \brief m_single_selected_index
+     * \details
+     * The selected index if there is only one item selected, otherwise it is invalid.
+     * It is updated when selection changed, so that the delegate does not need
+     * to query the selections when painting.
+     */
+    QPersistentModelIndex m_single_selected_index;
+    /*!
+     * \brief m_expanded_rect
+     * \details
+     * The rect of single selected item with its whole label in contents coordinates.
+     * The item is painted over the items below it by paintEvent(), there is no
+     * index widget, so that selection changes only update the changed items.
+     */
+    QRect m_expanded_rect;
 
     DirectoryViewProxyIface *m_proxy = nullptr;
 
     FileItemModel *m_model = nullptr;
     FileItemProxyFilterSortModel *m_sort_filter_proxy_model = nullptr;
 
+    /*!
+     * \brief m_model_cache
+     * \details
+     * The models of last visited locations, when going back or forward
+     * to them, the view will swap to the retained model instantly rather
+     * than enumerating the directory again.
+     */
+    ViewModelCache *m_model_cache = nullptr;
+    /*!
+     * \brief m_pending_scroll_value
+     * \details
+     * The scroll value of a retained location, it will be restored once
+     * the view's geometries are updated for the swapped model.
+     */
+    int m_pending_scroll_value = -1;
+
+    QTimer m_viewport_update_timer;
+    /*!
+     * \brief m_thumbnail_indexes
+     * \details
+     * The indexes of visible and prefetched items, used for finding the item
+     * need to be repainted when a thumbnail loaded.
+     */
+    QHash<QString, QPersistentModelIndex> m_thumbnail_indexes;
+
+    /*!
+     * \brief m_item_size
+     * \details
+     * The items have the same size, it is the delegate's size hint.
+     * Items are laid out in a uniform grid, so that their geometries are
+     * computed arithmetically from their rows, rather than QListView's
+     * layout which is linear in item count.
+     */
+    QSize m_item_size = QSize(105, 118);
+    QPoint m_item_offset = QPoint(10, 15);
+
+    QPersistentModelIndex m_hover_index;
+
+    /*!
+     * \brief m_rubber_band_rect
+     * \details
+     * The rubber band of drag selecting in contents coordinates.
+     */
+    QRect m_rubber_band_rect;
+    QPoint m_rubber_band_origin;
+
     QString m_current_uri = nullptr;
 };
 
@@ -0,0 +1,348 @@
+#include "list-view.h"
+#include "list-view-delegate.h"
+#include "file-item.h"
+#include "view-model-cache.h"
+#include "item-job-scheduler.h"
+
+#include <QHeaderView>
+#include <QScrollBar>
+
+#include <QDragEnterEvent>
+#include <QMimeData>
+#include <QDragMoveEvent>
+#include <QDropEvent>
+
+using namespace Peony;
+using namespace Peony::DirectoryView;
+
+ListView::ListView(QWidget *parent) : QTreeView(parent)
+{
+    init();
+}
+
+ListView::ListView(DirectoryViewProxyIface *proxy, QWidget *parent) : QTreeView(parent)
+{
+    m_proxy = proxy;
+    init();
+}
+
+ListView::~ListView()
+{
+
+}
+
+void ListView::init()
+{
+    setItemDelegate(new ListViewDelegate(this));
+
+    setSelectionMode(QTreeView::ExtendedSelection);
+    setSelectionBehavior(QTreeView::SelectRows);
+    setEditTriggers(QTreeView::NoEditTriggers);
+
+    //let QTreeView layout and paint only the visible rows.
+    setUniformRowHeights(true);
+    setRootIsDecorated(false);
+    setItemsExpandable(false);
+    setExpandsOnDoubleClick(false);
+    setAllColumnsShowFocus(true);
+    setAlternatingRowColors(true);
+    setIconSize(QSize(22, 22));
+
+    setDragEnabled(true);
+    setDragDropMode(QTreeView::DragDrop);
+    setDefaultDropAction(Qt::MoveAction);
+
+    m_model_cache = new ViewModelCache(this);
+
+    auto model = new FileItemModel(this);
+    auto proxyModel = new FileItemProxyFilterSortModel(model);
+    proxyModel->setSourceModel(model);
+    bindModel(model, proxyModel);
+
+    //NOTE: do not use ResizeToContents, it will measure all the rows.
+    header()->setSectionResizeMode(QHeaderView::Interactive);
+    header()->setStretchLastSection(true);
+    header()->resizeSection(FileItemModel::FileName, 300);
+    header()->setSortIndicator(FileItemModel::FileName, Qt::AscendingOrder);
+    setSortingEnabled(true);
+
+    m_viewport_update_timer.setSingleShot(true);
+    m_viewport_update_timer.setInterval(100);
+    connect(&m_viewport_update_timer, &QTimer::timeout, this, &ListView::updateViewport);
+    connect(verticalScrollBar(), &QScrollBar::valueChanged, this, [=](){
+        if (!m_viewport_update_timer.isActive())
+            m_viewport_update_timer.start();
+    });
+}
+
+void ListView::rebindProxy()
+{
+    if (!m_proxy) {
+        return;
+    }
+
+    disconnect();
+
+    connect(this, &ListView::doubleClicked, [=](const QModelIndex &index){
+        Q_EMIT m_proxy->viewDoubleClicked(index.data(FileItemModel::UriRole).toString());
+    });
+
+    bindModelSignals();
+}
+
+void ListView::bindModel(FileItemModel *model, FileItemProxyFilterSortModel *proxyModel)
+{
+    if (m_model) {
+        m_model->disconnect(this);
+        if (m_proxy)
+            m_model->disconnect(m_proxy);
+    }
+
+    m_model = model;
+    m_model->setParent(this);
+    m_sort_filter_proxy_model = proxyModel;
+
+    //QAbstractItemView::setModel() will not delete the old selection model.
+    auto oldSelectionModel = selectionModel();
+    setModel(m_sort_filter_proxy_model);
+    if (oldSelectionModel)
+        oldSelectionModel->deleteLater();
+
+    bindModelSignals();
+}
+
+void ListView::bindModelSignals()
+{
+    //this might be called both in binding model and proxy.
+    m_model->disconnect(this);
+    selectionModel()->disconnect(this);
+
+    if (!m_proxy) {
+        return;
+    }
+
+    m_model->disconnect(m_proxy);
+
+    connect(m_model, &FileItemModel::updated, this, [=](){
+        m_sort_filter_proxy_model->sort(header()->sortIndicatorSection(), header()->sortIndicatorOrder());
+        m_viewport_update_timer.start();
+    });
+
+    connect(m_model, &FileItemModel::findChildrenFinished,
+            m_proxy, &DirectoryViewProxyIface::viewDirectoryChanged);
+
+    connect(this->selectionModel(), &QItemSelectionModel::selectionChanged, this, [=](){
+        Q_EMIT m_proxy->viewSelectionChanged();
+    });
+}
+
+DirectoryViewProxyIface *ListView::getProxy()
+{
+    return m_proxy;
+}
+
+void ListView::setProxy(DirectoryViewProxyIface *proxy)
+{
+    if (!proxy)
+        return;
+
+    m_proxy = proxy;
+    rebindProxy();
+}
+
+//selection
+void ListView::setSelections(const QStringList &uris)
+{
+    clearSelection();
+    for (auto uri: uris) {
+        const QModelIndex index = m_sort_filter_proxy_model->indexFromUri(uri);
+        if (index.isValid()) {
+            selectionModel()->select(index, QItemSelectionModel::Select|QItemSelectionModel::Rows);
+        }
+    }
+}
+
+QStringList ListView::getSelections()
+{
+    //selectedIndexes() returns every column of selected rows.
+    QStringList uris;
+    QModelIndexList selections = selectionModel()->selectedRows();
+    for (auto index : selections) {
+        auto item = m_sort_filter_proxy_model->itemFromIndex(index);
+        uris<<item->uri();
+    }
+    return uris;
+}
+
+void ListView::invertSelections()
+{
+    QItemSelectionModel *selectionModel = this->selectionModel();
+    const QItemSelection currentSelection = selectionModel->selection();
+    this->selectAll();
+    selectionModel->select(currentSelection, QItemSelectionModel::Deselect);
+}
+
+void ListView::scrollToSelection(const QString &uri)
+{
+    auto index = m_sort_filter_proxy_model->indexFromUri(uri);
+    scrollTo(index);
+}
+
+//clipboard
+void ListView::setCutFiles(const QStringList &uris)
+{
+    Q_UNUSED(uris);
+}
+
+//location
+void ListView::setDirectoryUri(const QString &uri)
+{
+    m_current_uri = uri;
+}
+
+const QString ListView::getDirectoryUri()
+{
+    return m_model->getRootUri();
+}
+
+void ListView::beginLocationChange()
+{
+    m_pending_scroll_value = -1;
+
+    auto rootUri = m_model->getRootUri();
+    if (rootUri.isNull() || rootUri == m_current_uri) {
+        //first location or refresh, enumerate in current model.
+        m_model->setRootUri(m_current_uri);
+        return;
+    }
+
+    ViewModelCache::Location current;
+    current.model = m_model;
+    current.proxyModel = m_sort_filter_proxy_model;
+    current.scrollValue = verticalScrollBar()->value();
+    current.selections = getSelections();
+
+    auto location = m_model_cache->take(m_current_uri);
+    if (location.model) {
+        bindModel(location.model, location.proxyModel);
+        m_model_cache->retain(rootUri, current);
+
+        //the retained model might be sorted by another column.
+        m_sort_filter_proxy_model->sort(header()->sortIndicatorSection(), header()->sortIndicatorOrder());
+        m_pending_scroll_value = location.scrollValue;
+        setSelections(location.selections);
+        m_viewport_update_timer.start();
+        if (m_proxy)
+            Q_EMIT m_proxy->viewDirectoryChanged();
+
+        m_model->revalidate();
+        return;
+    }
+
+    auto model = new FileItemModel(this);
+    auto proxyModel = new FileItemProxyFilterSortModel(model);
+    proxyModel->setSourceModel(model);
+    bindModel(model, proxyModel);
+    m_model_cache->retain(rootUri, current);
+
+    m_model->setRootUri(m_current_uri);
+}
+
+void ListView::stopLocationChange()
+{
+    m_model->cancelFindChildren();
+}
+
+//other
+void ListView::open(const QStringList &uris, bool newWindow)
+{
+    Q_UNUSED(uris);
+    Q_UNUSED(newWindow);
+}
+
+void ListView::closeView()
+{
+    this->deleteLater();
+}
+
+void ListView::dragEnterEvent(QDragEnterEvent *e)
+{
+    if (e->mimeData()->hasUrls()) {
+        e->setDropAction(Qt::MoveAction);
+        e->accept();
+    }
+}
+
+void ListView::dragMoveEvent(QDragMoveEvent *e)
+{
+    if (this == e->source()) {
+        return QTreeView::dragMoveEvent(e);
+    }
+    e->setDropAction(Qt::MoveAction);
+    e->accept();
+}
+
+void ListView::dropEvent(QDropEvent *e)
+{
+    if (e->source() == this) {
+        if (indexAt(e->pos()).isValid()) {
+            return QTreeView::dropEvent(e);
+        }
+        else {
+            return;
+        }
+    }
+    e->setDropAction(Qt::MoveAction);
+    auto proxy_index = indexAt(e->pos());
+    auto index = m_sort_filter_proxy_model->mapToSource(proxy_index);
+    m_model->dropMimeData(e->mimeData(), Qt::MoveAction, 0, 0, index);
+}
+
+void ListView::resizeEvent(QResizeEvent *e)
+{
+    QTreeView::resizeEvent(e);
+    m_viewport_update_timer.start();
+}
+
+void ListView::updateGeometries()
+{
+    QTreeView::updateGeometries();
+    if (m_pending_scroll_value < 0)
+        return;
+
+    if (verticalScrollBar()->maximum() >= m_pending_scroll_value) {
+        verticalScrollBar()->setValue(m_pending_scroll_value);
+        m_pending_scroll_value = -1;
+    }
+}
+
+void ListView::updateViewport()
+{
+    auto first = indexAt(QPoint(0, 0));
+    if (!first.isValid())
+        return;
+
+    //rows are uniform, so the visible rows can be computed directly.
+    int height = rowHeight(first);
+    if (height <= 0)
+        return;
+    int page = viewport()->height()/height + 1;
+    int firstRow = first.row();
+    int rowCount = m_sort_filter_proxy_model->rowCount(QModelIndex());
+
+    QStringList visibleUris;
+    QStringList prefetchUris;
+    int start = qMax(0, firstRow - page);
+    int end = qMin(rowCount, firstRow + 2*page);
+    for (int row = start; row < end; row++) {
+        auto index = m_sort_filter_proxy_model->index(row, FileItemModel::FileName);
+        auto uri = index.data(FileItemModel::UriRole).toString();
+        if (row >= firstRow && row < firstRow + page) {
+            visibleUris<<uri;
+        } else {
+            prefetchUris<<uri;
+        }
+    }
+
+    ItemJobScheduler::getInstance()->setViewport(this, visibleUris, prefetchUris);
+}
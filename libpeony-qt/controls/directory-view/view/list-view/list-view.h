@@ -0,0 +1,113 @@
+#ifndef LISTVIEW_H
+#define LISTVIEW_H
+
+#include "peony-core_global.h"
+#include "directory-view-plugin-iface.h"
+#include "file-item-model.h"
+#include "file-item-proxy-filter-sort-model.h"
+#include <QTreeView>
+#include <QTimer>
+
+namespace Peony {
+
+namespace DirectoryView {
+
+class ViewModelCache;
+
+/*!
+ * \brief The ListView class
+ * <br>
+ * ListView is the details view of peony-qt, it shows the name, size, type and
+ * modified date columns of FileItemModel. It is desgined for huge directories,
+ * the rows are uniform, there is no index widget and no expandable item. So that
+ * QTreeView can layout and paint only the visible rows.
+ * </br>
+ * \note
+ * Do not set a resize mode depends on contents for header, it will measure
+ * all the rows.
+ * \see IconView.
+ */
+class PEONYCORESHARED_EXPORT ListView : public QTreeView, public DirectoryViewIface
+{
+    Q_OBJECT
+public:
+    explicit ListView(QWidget *parent = nullptr);
+    explicit ListView(DirectoryViewProxyIface *proxy, QWidget *parent = nullptr);
+    ~ListView() override;
+
+    const QString viewId() override {return tr("List View");}
+
+    void setProxy(DirectoryViewProxyIface *proxy) override;
+
+    DirectoryViewProxyIface *getProxy() override;
+
+    //location
+    const QString getDirectoryUri() override;
+
+    //selections
+    QStringList getSelections() override;
+
+public Q_SLOTS:
+    //location
+    void open(const QStringList &uris, bool newWindow) override;
+    void setDirectoryUri(const QString &uri) override;
+    void beginLocationChange() override;
+    void stopLocationChange() override;
+    void closeView() override;
+
+    //selections
+    void setSelections(const QStringList &uris) override;
+    void invertSelections() override;
+    void scrollToSelection(const QString &uri) override;
+
+    //clipboard
+    void setCutFiles(const QStringList &uris) override;
+
+protected:
+    void dragEnterEvent(QDragEnterEvent *e) override;
+    void dragMoveEvent(QDragMoveEvent *e) override;
+    void dropEvent(QDropEvent *e) override;
+
+    void resizeEvent(QResizeEvent *e) override;
+    void updateGeometries() override;
+
+protected:
+    void init();
+    void rebindProxy();
+    /*!
+     * \brief bindModel
+     * \param model
+     * \param proxyModel
+     * \see IconView::bindModel().
+     */
+    void bindModel(FileItemModel *model, FileItemProxyFilterSortModel *proxyModel);
+    void bindModelSignals();
+
+    /*!
+     * \brief updateViewport
+     * <br>
+     * Report the visible rows and a prefetch band of one page around them
+     * to ItemJobScheduler. This only walks the rows in band.
+     * </br>
+     */
+    void updateViewport();
+
+private:
+    DirectoryViewProxyIface *m_proxy = nullptr;
+
+    FileItemModel *m_model = nullptr;
+    FileItemProxyFilterSortModel *m_sort_filter_proxy_model = nullptr;
+
+    ViewModelCache *m_model_cache = nullptr;
+    int m_pending_scroll_value = -1;
+
+    QTimer m_viewport_update_timer;
+
+    QString m_current_uri = nullptr;
+};
+
+}
+
+}
+
+#endif // LISTVIEW_H
@@ -1 +1,7 @@
 INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/list-view.h
+
+SOURCES += \
+    $$PWD/list-view.cpp
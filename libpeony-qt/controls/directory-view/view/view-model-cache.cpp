@@ -0,0 +1,92 @@
+#include "view-model-cache.h"
+#include "file-item-model.h"
+#include "file-item-proxy-filter-sort-model.h"
+
+using namespace Peony;
+using namespace Peony::DirectoryView;
+
+ViewModelCache::ViewModelCache(QObject *parent) : QObject(parent)
+{
+
+}
+
+ViewModelCache::~ViewModelCache()
+{
+
+}
+
+void ViewModelCache::setMaxLocations(int count)
+{
+    m_max_locations = count;
+    evict();
+}
+
+void ViewModelCache::setMaxRetainedRows(int rows)
+{
+    m_max_retained_rows = rows;
+    evict();
+}
+
+void ViewModelCache::retain(const QString &uri, const Location &location)
+{
+    if (uri.isNull() || !location.model)
+        return;
+
+    if (m_locations.contains(uri)) {
+        auto old = m_locations.take(uri);
+        m_lru.removeOne(uri);
+        if (old.model != location.model)
+            release(old);
+    }
+
+    location.model->setParent(this);
+    m_locations.insert(uri, location);
+    m_lru.append(uri);
+    evict();
+}
+
+ViewModelCache::Location ViewModelCache::take(const QString &uri)
+{
+    if (!m_locations.contains(uri))
+        return Location();
+
+    m_lru.removeOne(uri);
+    auto location = m_locations.take(uri);
+    //NOTE: a retained model might have changed its root by itself,
+    //for example, the directory was deleted or unmounted.
+    if (location.model->getRootUri() != uri) {
+        release(location);
+        return Location();
+    }
+    return location;
+}
+
+void ViewModelCache::clear()
+{
+    for (auto location : m_locations) {
+        release(location);
+    }
+    m_locations.clear();
+    m_lru.clear();
+}
+
+void ViewModelCache::evict()
+{
+    int rows = 0;
+    for (auto location : m_locations) {
+        rows += location.model->rowCount(QModelIndex());
+    }
+
+    while (!m_lru.isEmpty() && (m_lru.count() > m_max_locations || rows > m_max_retained_rows)) {
+        auto location = m_locations.take(m_lru.takeFirst());
+        rows -= location.model->rowCount(QModelIndex());
+        release(location);
+    }
+}
+
+void ViewModelCache::release(const Location &location)
+{
+    //the proxy model is the child of the model.
+    if (location.model)
+        location.model->deleteLater();
+}
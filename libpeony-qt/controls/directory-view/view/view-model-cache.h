@@ -0,0 +1,93 @@
+#ifndef VIEWMODELCACHE_H
+#define VIEWMODELCACHE_H
+
+#include <QObject>
+#include <QHash>
+#include <QStringList>
+
+namespace Peony {
+
+class FileItemModel;
+class FileItemProxyFilterSortModel;
+
+namespace DirectoryView {
+
+/*!
+ * \brief The ViewModelCache class
+ * \details
+ * A directory view used to tear down its model and enumerate the directory
+ * again for every location change, even when the user just went back or
+ * forward in history. This class keeps the models of the last visited
+ * locations alive, so that a view can swap back to them instantly.
+ * <br>
+ * A retained model is still monitored by its root item's FileWatcher,
+ * so it keeps receiving the changes of the directory while it is hidden.
+ * The view should revalidate it again when it was taken out of cache,
+ * for the locations which don't support monitoring.
+ * </br>
+ * \note
+ * The retained models are cost limited by the count of locations and
+ * the total rows of them. The least recently retained model will be
+ * destroyed first.
+ */
+class ViewModelCache : public QObject
+{
+    Q_OBJECT
+public:
+    struct Location {
+        FileItemModel *model = nullptr;
+        FileItemProxyFilterSortModel *proxyModel = nullptr;
+        int scrollValue = 0;
+        QStringList selections;
+    };
+
+    explicit ViewModelCache(QObject *parent = nullptr);
+    ~ViewModelCache() override;
+
+    void setMaxLocations(int count);
+    void setMaxRetainedRows(int rows);
+
+    /*!
+     * \brief retain
+     * \param uri, the root uri of the location's model.
+     * \param location
+     * \details
+     * The cache will take the ownership of the location's model,
+     * the model will be reparented to the cache. If there is a location with same uri in cache, it will be replaced.
+     */
+    void retain(const QString &uri, const Location &location);
+    /*!
+     * \brief take
+     * \param uri
+     * \return the retained location, or an empty location if there is no
+     * valid location for the uri.
+     * \details
+     * The caller will take the ownership of the location's model,
+     * and should reparent it.
+     */
+    Location take(const QString &uri);
+
+    void clear();
+
+protected:
+    void evict();
+    void release(const Location &location);
+
+private:
+    /*!
+     * \brief m_lru
+     * \details
+     * The most recently retained location is at the back.
+     */
+    QStringList m_lru;
+    QHash<QString, Location> m_locations;
+
+    int m_max_locations = 5;
+    int m_max_retained_rows = 20000;
+};
+
+}
+
+}
+
+#endif // VIEWMODELCACHE_H
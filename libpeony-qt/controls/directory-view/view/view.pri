@@ -4,7 +4,9 @@ include(icon-view/icon-view.pri)
 include(list-view/list-view.pri)
 
 HEADERS += \
-    $$PWD/standard-view-proxy.h
+    $$PWD/standard-view-proxy.h \
+    $$PWD/view-model-cache.h
 
 SOURCES += \
-    $$PWD/standard-view-proxy.cpp
+    $$PWD/standard-view-proxy.cpp \
+    $$PWD/view-model-cache.cpp
@@ -0,0 +1,165 @@
+#include "file-checksum.h"
+
+#include <QtEndian>
+
+#include <string.h>
+
+//the buffer of reading files for hashing.
+#define HASH_BUFFER_SIZE (1024*1024)
+
+using namespace Peony;
+
+static const quint64 PRIME64_1 = 0x9E3779B185EBCA87ULL;
+static const quint64 PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+static const quint64 PRIME64_3 = 0x165667B19E3779F9ULL;
+static const quint64 PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+static const quint64 PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+static inline quint64 rotl64(quint64 x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline quint64 read64(const unsigned char *p)
+{
+    return qFromLittleEndian<quint64>(p);
+}
+
+static inline quint64 read32(const unsigned char *p)
+{
+    return qFromLittleEndian<quint32>(p);
+}
+
+static inline quint64 round64(quint64 acc, quint64 input)
+{
+    acc += input * PRIME64_2;
+    acc = rotl64(acc, 31);
+    return acc * PRIME64_1;
+}
+
+static inline quint64 mergeRound64(quint64 acc, quint64 val)
+{
+    acc ^= round64(0, val);
+    return acc * PRIME64_1 + PRIME64_4;
+}
+
+FileChecksum::FileChecksum(quint64 seed)
+{
+    m_seed = seed;
+    reset();
+}
+
+void FileChecksum::reset()
+{
+    m_accumulators[0] = m_seed + PRIME64_1 + PRIME64_2;
+    m_accumulators[1] = m_seed + PRIME64_2;
+    m_accumulators[2] = m_seed;
+    m_accumulators[3] = m_seed - PRIME64_1;
+    m_buffer_size = 0;
+    m_length = 0;
+    m_complete = false;
+}
+
+void FileChecksum::update(const char *data, qint64 length)
+{
+    auto p = reinterpret_cast<const unsigned char *>(data);
+    auto end = p + length;
+    m_length += length;
+
+    //fill the stripe left by the last update first.
+    if (m_buffer_size + length < 32) {
+        memcpy(m_buffer + m_buffer_size, p, size_t(length));
+        m_buffer_size += int(length);
+        return;
+    }
+    if (m_buffer_size > 0) {
+        int fill = 32 - m_buffer_size;
+        memcpy(m_buffer + m_buffer_size, p, size_t(fill));
+        for (int i = 0; i < 4; i++) {
+            m_accumulators[i] = round64(m_accumulators[i], read64(m_buffer + i*8));
+        }
+        p += fill;
+        m_buffer_size = 0;
+    }
+
+    //the four lanes are independent, the compiler could keep them in registers.
+    quint64 v1 = m_accumulators[0];
+    quint64 v2 = m_accumulators[1];
+    quint64 v3 = m_accumulators[2];
+    quint64 v4 = m_accumulators[3];
+    while (p + 32 <= end) {
+        v1 = round64(v1, read64(p));
+        v2 = round64(v2, read64(p + 8));
+        v3 = round64(v3, read64(p + 16));
+        v4 = round64(v4, read64(p + 24));
+        p += 32;
+    }
+    m_accumulators[0] = v1;
+    m_accumulators[1] = v2;
+    m_accumulators[2] = v3;
+    m_accumulators[3] = v4;
+
+    if (p < end) {
+        memcpy(m_buffer, p, size_t(end - p));
+        m_buffer_size = int(end - p);
+    }
+}
+
+quint64 FileChecksum::digest() const
+{
+    quint64 h;
+    if (m_length >= 32) {
+        h = rotl64(m_accumulators[0], 1) + rotl64(m_accumulators[1], 7) +
+                rotl64(m_accumulators[2], 12) + rotl64(m_accumulators[3], 18);
+        for (int i = 0; i < 4; i++) {
+            h = mergeRound64(h, m_accumulators[i]);
+        }
+    } else {
+        h = m_seed + PRIME64_5;
+    }
+    h += quint64(m_length);
+
+    const unsigned char *p = m_buffer;
+    const unsigned char *end = m_buffer + m_buffer_size;
+    while (p + 8 <= end) {
+        h ^= round64(0, read64(p));
+        h = rotl64(h, 27) * PRIME64_1 + PRIME64_4;
+        p += 8;
+    }
+    if (p + 4 <= end) {
+        h ^= read32(p) * PRIME64_1;
+        h = rotl64(h, 23) * PRIME64_2 + PRIME64_3;
+        p += 4;
+    }
+    while (p < end) {
+        h ^= (*p) * PRIME64_5;
+        h = rotl64(h, 11) * PRIME64_1;
+        p++;
+    }
+
+    h ^= h >> 33;
+    h *= PRIME64_2;
+    h ^= h >> 29;
+    h *= PRIME64_3;
+    h ^= h >> 32;
+    return h;
+}
+
+bool FileChecksum::hashFile(GFile *file, FileChecksum *checksum, GCancellable *cancellable, GError **error)
+{
+    checksum->reset();
+    GFileInputStream *stream = g_file_read(file, cancellable, error);
+    if (!stream)
+        return false;
+
+    char *buffer = static_cast<char *>(g_malloc(HASH_BUFFER_SIZE));
+    gssize read_size = 0;
+    while ((read_size = g_input_stream_read(G_INPUT_STREAM(stream), buffer, HASH_BUFFER_SIZE, cancellable, error)) > 0) {
+        checksum->update(buffer, read_size);
+    }
+    g_free(buffer);
+    g_object_unref(stream);
+
+    checksum->setComplete(read_size == 0);
+    return read_size == 0;
+}
@@ -0,0 +1,53 @@
+#ifndef FILECHECKSUM_H
+#define FILECHECKSUM_H
+
+#include "peony-core_global.h"
+#include <gio/gio.h>
+
+namespace Peony {
+
+/*!
+ * \brief The FileChecksum class
+ * <br>
+ * FileChecksum computes the XXH64 digest of a file incrementally. XXH64 is a
+ * non-cryptographic hash, it runs at the speed of memory, so that it could be
+ * computed in the copy loop without slowing down the transfer. It is used for
+ * verifying that a target is the same as its source.
+ * </br>
+ * <br>
+ * A checksum is complete only if all the data of file were fed from the beginning,
+ * the copy engine marks it complete when it hashed the whole source while writing.
+ * </br>
+ * \see FileCopyEngine::verify().
+ */
+class PEONYCORESHARED_EXPORT FileChecksum
+{
+public:
+    explicit FileChecksum(quint64 seed = 0);
+
+    void reset();
+    void update(const char *data, qint64 length);
+    quint64 digest() const;
+    qint64 length() const {return m_length;}
+
+    void setComplete(bool complete = true) {m_complete = complete;}
+    bool isComplete() const {return m_complete;}
+
+    /*!
+     * \brief hashFile
+     * \return true if the whole file was hashed, the checksum is complete then.
+     */
+    static bool hashFile(GFile *file, FileChecksum *checksum, GCancellable *cancellable, GError **error);
+
+private:
+    quint64 m_seed = 0;
+    quint64 m_accumulators[4];
+    unsigned char m_buffer[32];
+    int m_buffer_size = 0;
+    qint64 m_length = 0;
+    bool m_complete = false;
+};
+
+}
+
+#endif // FILECHECKSUM_H
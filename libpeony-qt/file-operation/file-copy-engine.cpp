@@ -0,0 +1,719 @@
+#include "file-copy-engine.h"
+#include "file-transfer-journal.h"
+#include "file-checksum.h"
+
+#include <QThreadPool>
+#include <QSemaphore>
+#include <QAtomicInt>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdlib.h>
+
+#include <linux/fs.h>
+
+#if defined(__GLIBC__) && defined(__GLIBC_PREREQ)
+#if __GLIBC_PREREQ(2, 27)
+#define HAVE_COPY_FILE_RANGE
+#endif
+#endif
+
+//the progress and cancellation are checked between chunks.
+#define COPY_CHUNK_SIZE (8*1024*1024)
+//the chunk recorded in transfer journal, it is synced before recording.
+#define JOURNAL_CHUNK_SIZE (16*1024*1024)
+//the smaller files are copied again rather than resumed.
+#define JOURNAL_MIN_SIZE (4*JOURNAL_CHUNK_SIZE)
+//the alignment of O_DIRECT buffers, offsets and sizes.
+#define DIRECT_IO_ALIGNMENT 4096
+
+static QAtomicInt s_chunk_size = COPY_CHUNK_SIZE;
+static QAtomicInteger<qint64> s_chunked_copy_threshold = qint64(128*1024*1024);
+static QAtomicInt s_direct_io = 0;
+static QAtomicInt s_cache_dropped = 1;
+
+namespace Peony {
+
+/*!
+ * \brief The FileChunkReader class
+ * <br>
+ * The reader of chunked copy. It reads the source into two buffers in turn,
+ * while the engine is writing the other one.
+ * </br>
+ */
+class FileChunkReader : public QRunnable
+{
+public:
+    FileChunkReader(int fd, goffset total, int chunkSize, char **buffers, qint64 *lengths,
+                    QSemaphore *freeBuffers, QSemaphore *usedBuffers, QAtomicInt *stopped) {
+        m_fd = fd;
+        m_total = total;
+        m_chunk_size = chunkSize;
+        m_buffers = buffers;
+        m_lengths = lengths;
+        m_free_buffers = freeBuffers;
+        m_used_buffers = usedBuffers;
+        m_stopped = stopped;
+    }
+
+    void run() override {
+        goffset offset = 0;
+        int index = 0;
+        while (offset < m_total) {
+            m_free_buffers->acquire();
+            if (m_stopped->load())
+                return;
+
+            //a negative length is the errno.
+            qint64 length = 0;
+            while (length < m_chunk_size && offset + length < m_total) {
+                ssize_t ret = pread(m_fd, m_buffers[index] + length, size_t(m_chunk_size - length), off_t(offset + length));
+                if (ret < 0 && errno == EINTR)
+                    continue;
+                if (ret <= 0) {
+                    length = ret < 0? -errno: -EIO;
+                    break;
+                }
+                length += ret;
+            }
+            m_lengths[index] = length;
+            m_used_buffers->release();
+            if (length <= 0)
+                return;
+
+            if (s_cache_dropped.load())
+                posix_fadvise(m_fd, off_t(offset), off_t(length), POSIX_FADV_DONTNEED);
+            offset += length;
+            index ^= 1;
+        }
+    }
+
+private:
+    int m_fd = -1;
+    goffset m_total = 0;
+    int m_chunk_size = 0;
+    char **m_buffers = nullptr;
+    qint64 *m_lengths = nullptr;
+    QSemaphore *m_free_buffers = nullptr;
+    QSemaphore *m_used_buffers = nullptr;
+    QAtomicInt *m_stopped = nullptr;
+};
+
+/*!
+ * \brief The FileHashJob class
+ * <br>
+ * Hash a file in another thread when verifying.
+ * </br>
+ */
+class FileHashJob : public QRunnable
+{
+public:
+    FileHashJob(GFile *file, FileChecksum *checksum, GCancellable *cancellable, GError **error) {
+        m_file = file;
+        m_checksum = checksum;
+        m_cancellable = cancellable;
+        m_error = error;
+    }
+
+    void run() override {
+        FileChecksum::hashFile(m_file, m_checksum, m_cancellable, m_error);
+    }
+
+private:
+    GFile *m_file = nullptr;
+    FileChecksum *m_checksum = nullptr;
+    GCancellable *m_cancellable = nullptr;
+    GError **m_error = nullptr;
+};
+
+}
+
+using namespace Peony;
+
+void FileCopyEngine::setChunkSize(int size)
+{
+    //O_DIRECT needs aligned buffers.
+    int aligned = qMax(DIRECT_IO_ALIGNMENT, size - size % DIRECT_IO_ALIGNMENT);
+    s_chunk_size.store(aligned);
+}
+
+int FileCopyEngine::chunkSize()
+{
+    return s_chunk_size.load();
+}
+
+void FileCopyEngine::setChunkedCopyThreshold(qint64 size)
+{
+    s_chunked_copy_threshold.store(size);
+}
+
+qint64 FileCopyEngine::chunkedCopyThreshold()
+{
+    return s_chunked_copy_threshold.load();
+}
+
+void FileCopyEngine::setDirectIO(bool enabled)
+{
+    s_direct_io.store(enabled);
+}
+
+bool FileCopyEngine::isDirectIO()
+{
+    return s_direct_io.load();
+}
+
+void FileCopyEngine::setCacheDropped(bool dropped)
+{
+    s_cache_dropped.store(dropped);
+}
+
+bool FileCopyEngine::isCacheDropped()
+{
+    return s_cache_dropped.load();
+}
+
+bool FileCopyEngine::copy(GFile *source,
+                          GFile *destination,
+                          GFileCopyFlags flags,
+                          GCancellable *cancellable,
+                          GFileProgressCallback progress_callback,
+                          gpointer progress_callback_data,
+                          GError **error,
+                          FileChecksum *checksum)
+{
+    if (!(flags & G_FILE_COPY_BACKUP)) {
+        char *source_path = g_file_get_path(source);
+        char *dest_path = g_file_get_path(destination);
+        NativeResult result = Unsupported;
+        if (source_path && dest_path) {
+            result = nativeCopy(source_path, dest_path, flags, cancellable,
+                                progress_callback, progress_callback_data, error, checksum);
+        }
+        g_free(source_path);
+        g_free(dest_path);
+
+        if (result == Copied) {
+            if (flags & G_FILE_COPY_ALL_METADATA) {
+                //the times, permissions and xattrs, ignore the errors as gio does.
+                g_file_copy_attributes(source, destination, flags, cancellable, nullptr);
+            }
+            return true;
+        }
+        if (result == Failed)
+            return false;
+    }
+
+    return g_file_copy(source, destination, flags, cancellable,
+                       progress_callback, progress_callback_data, error);
+}
+
+FileCopyEngine::NativeResult FileCopyEngine::nativeCopy(const char *source_path,
+                                                        const char *dest_path,
+                                                        GFileCopyFlags flags,
+                                                        GCancellable *cancellable,
+                                                        GFileProgressCallback progress_callback,
+                                                        gpointer progress_callback_data,
+                                                        GError **error,
+                                                        FileChecksum *checksum)
+{
+    struct stat source_stat;
+    int ret = (flags & G_FILE_COPY_NOFOLLOW_SYMLINKS)? lstat(source_path, &source_stat): stat(source_path, &source_stat);
+    if (ret != 0 || !S_ISREG(source_stat.st_mode))
+        return Unsupported;
+
+    int source_fd = open(source_path, O_RDONLY|O_CLOEXEC);
+    if (source_fd < 0)
+        return Unsupported;
+
+    //never write into an existed target. when overwriting, the data is written
+    //to a new file in dest dir, which replaces the target once it is completed.
+    char *write_path = nullptr;
+    int dest_fd = -1;
+    if (flags & G_FILE_COPY_OVERWRITE) {
+        struct stat dest_stat;
+        if (lstat(dest_path, &dest_stat) == 0) {
+            if (dest_stat.st_dev == source_stat.st_dev && dest_stat.st_ino == source_stat.st_ino) {
+                close(source_fd);
+                g_set_error_literal(error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT, "Can not copy a file over itself");
+                return Failed;
+            }
+            //let gio replace a target which is not a regular file, such as a symbolic link.
+            if (!S_ISREG(dest_stat.st_mode)) {
+                close(source_fd);
+                return Unsupported;
+            }
+        }
+        char *dest_dir = g_path_get_dirname(dest_path);
+        char *dest_name = g_path_get_basename(dest_path);
+        write_path = g_strdup_printf("%s/.%s.XXXXXX", dest_dir, dest_name);
+        g_free(dest_dir);
+        g_free(dest_name);
+        dest_fd = mkostemp(write_path, O_CLOEXEC);
+        if (dest_fd >= 0)
+            fchmod(dest_fd, source_stat.st_mode & 0777);
+    } else {
+        //let gio report the existed target.
+        write_path = g_strdup(dest_path);
+        dest_fd = open(write_path, O_WRONLY|O_CREAT|O_EXCL|O_NOFOLLOW|O_CLOEXEC, source_stat.st_mode & 0777);
+    }
+    if (dest_fd < 0) {
+        g_free(write_path);
+        close(source_fd);
+        return Unsupported;
+    }
+
+    goffset total = source_stat.st_size;
+    goffset offset = 0;
+    int err_code = 0;
+    bool cloned = false;
+
+    if (progress_callback)
+        progress_callback(0, total, progress_callback_data);
+
+#ifdef FICLONE
+    if (total > 0 && ioctl(dest_fd, FICLONE, source_fd) == 0) {
+        cloned = true;
+        offset = total;
+    }
+#endif
+
+    //the large file is copied through our buffers, so that the page cache
+    //could be controlled.
+    bool chunked = false;
+    if (!cloned && total >= s_chunked_copy_threshold.load()) {
+        chunked = true;
+        err_code = chunkedCopy(source_fd, dest_fd, total, &offset, cancellable,
+                               progress_callback, progress_callback_data, checksum);
+    }
+
+#ifdef HAVE_COPY_FILE_RANGE
+    //copy_file_range is not supported across file systems before linux 5.3.
+    while (!cloned && !chunked && offset < total) {
+        if (g_cancellable_is_cancelled(cancellable)) {
+            err_code = ECANCELED;
+            break;
+        }
+        ssize_t copied = copy_file_range(source_fd, nullptr, dest_fd, nullptr, COPY_CHUNK_SIZE, 0);
+        if (copied <= 0) {
+            if (copied < 0 && offset > 0)
+                err_code = errno;
+            break;
+        }
+        offset += copied;
+        if (progress_callback)
+            progress_callback(offset, total, progress_callback_data);
+    }
+#endif
+
+    while (!cloned && !chunked && err_code == 0 && offset < total) {
+        if (g_cancellable_is_cancelled(cancellable)) {
+            err_code = ECANCELED;
+            break;
+        }
+        off_t source_offset = offset;
+        ssize_t copied = sendfile(dest_fd, source_fd, &source_offset, COPY_CHUNK_SIZE);
+        if (copied <= 0) {
+            err_code = copied < 0? errno: EIO;
+            break;
+        }
+        offset += copied;
+        if (progress_callback)
+            progress_callback(offset, total, progress_callback_data);
+    }
+
+    close(source_fd);
+    if (close(dest_fd) != 0 && err_code == 0)
+        err_code = errno;
+    if (err_code == 0 && offset >= total && (flags & G_FILE_COPY_OVERWRITE) && rename(write_path, dest_path) != 0)
+        err_code = errno;
+
+    if (err_code == 0 && offset >= total) {
+        g_free(write_path);
+        if (progress_callback)
+            progress_callback(total, total, progress_callback_data);
+        return Copied;
+    }
+
+    //do not leave a partial file, it is the one created here, never the old target.
+    unlink(write_path);
+    g_free(write_path);
+    if (err_code == ECANCELED) {
+        g_set_error_literal(error, G_IO_ERROR, G_IO_ERROR_CANCELLED, "Operation was cancelled");
+        return Failed;
+    }
+    //nothing copied, gio might be able to deal with it.
+    if (offset == 0)
+        return Unsupported;
+
+    g_set_error_literal(error, G_IO_ERROR, g_io_error_from_errno(err_code), g_strerror(err_code));
+    return Failed;
+}
+
+int FileCopyEngine::chunkedCopy(int source_fd,
+                                int dest_fd,
+                                goffset total,
+                                goffset *offset,
+                                GCancellable *cancellable,
+                                GFileProgressCallback progress_callback,
+                                gpointer progress_callback_data,
+                                FileChecksum *checksum)
+{
+    int chunk_size = s_chunk_size.load();
+    bool cache_dropped = s_cache_dropped.load();
+    bool direct_io = false;
+    if (s_direct_io.load()) {
+        //the file system might not support it, then copy with page cache.
+        direct_io = fcntl(source_fd, F_SETFL, fcntl(source_fd, F_GETFL) | O_DIRECT) == 0 &&
+                fcntl(dest_fd, F_SETFL, fcntl(dest_fd, F_GETFL) | O_DIRECT) == 0;
+    }
+
+    char *buffers[2] = {nullptr, nullptr};
+    if (posix_memalign(reinterpret_cast<void **>(&buffers[0]), DIRECT_IO_ALIGNMENT, size_t(chunk_size)) != 0)
+        return ENOMEM;
+    if (posix_memalign(reinterpret_cast<void **>(&buffers[1]), DIRECT_IO_ALIGNMENT, size_t(chunk_size)) != 0) {
+        free(buffers[0]);
+        return ENOMEM;
+    }
+
+    qint64 lengths[2] = {0, 0};
+    QSemaphore freeBuffers(2);
+    QSemaphore usedBuffers;
+    QAtomicInt stopped = 0;
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(1);
+    pool.start(new FileChunkReader(source_fd, total, chunk_size, buffers, lengths,
+                                   &freeBuffers, &usedBuffers, &stopped));
+
+    int err_code = 0;
+    int index = 0;
+    while (*offset < total) {
+        usedBuffers.acquire();
+        qint64 length = lengths[index];
+        if (length <= 0) {
+            err_code = length < 0? int(-length): EIO;
+            break;
+        }
+
+        //the tail which is not aligned can not be written directly.
+        if (direct_io && length % DIRECT_IO_ALIGNMENT != 0) {
+            fcntl(dest_fd, F_SETFL, fcntl(dest_fd, F_GETFL) & ~O_DIRECT);
+            direct_io = false;
+        }
+
+        qint64 written = 0;
+        while (written < length) {
+            ssize_t ret = pwrite(dest_fd, buffers[index] + written, size_t(length - written), off_t(*offset + written));
+            if (ret < 0 && errno == EINTR)
+                continue;
+            if (ret <= 0) {
+                err_code = ret < 0? errno: EIO;
+                break;
+            }
+            written += ret;
+        }
+        if (err_code != 0)
+            break;
+
+        //the dirty pages can not be dropped, start the write back of this chunk
+        //and drop the previous one, which has been written back meanwhile.
+        if (cache_dropped && !direct_io) {
+            sync_file_range(dest_fd, off_t(*offset), off_t(length), SYNC_FILE_RANGE_WRITE);
+            if (*offset >= chunk_size) {
+                off_t previous = off_t(*offset - chunk_size);
+                sync_file_range(dest_fd, previous, chunk_size,
+                                SYNC_FILE_RANGE_WAIT_BEFORE|SYNC_FILE_RANGE_WRITE|SYNC_FILE_RANGE_WAIT_AFTER);
+                posix_fadvise(dest_fd, previous, chunk_size, POSIX_FADV_DONTNEED);
+            }
+        }
+
+        //hash the chunk while the reader is reading the next one.
+        if (checksum)
+            checksum->update(buffers[index], length);
+
+        *offset += length;
+        freeBuffers.release();
+        index ^= 1;
+        if (progress_callback)
+            progress_callback(*offset, total, progress_callback_data);
+
+        if (g_cancellable_is_cancelled(cancellable)) {
+            err_code = ECANCELED;
+            break;
+        }
+    }
+
+    //wake the reader up if it is waiting for a buffer.
+    stopped.store(1);
+    freeBuffers.release(2);
+    pool.waitForDone();
+
+    if (cache_dropped && !direct_io && err_code == 0)
+        posix_fadvise(dest_fd, 0, 0, POSIX_FADV_DONTNEED);
+    if (checksum && err_code == 0)
+        checksum->setComplete();
+
+    free(buffers[0]);
+    free(buffers[1]);
+    return err_code;
+}
+
+bool FileCopyEngine::copyResumable(GFile *source,
+                                   GFile *destination,
+                                   GFileCopyFlags flags,
+                                   GCancellable *cancellable,
+                                   GFileProgressCallback progress_callback,
+                                   gpointer progress_callback_data,
+                                   GError **error,
+                                   FileChecksum *checksum)
+{
+    if (!(flags & G_FILE_COPY_BACKUP)) {
+        char *source_path = g_file_get_path(source);
+        char *dest_path = g_file_get_path(destination);
+        NativeResult result = Unsupported;
+        if (source_path && dest_path) {
+            result = journaledCopy(source, destination, source_path, dest_path, flags, cancellable,
+                                   progress_callback, progress_callback_data, error, checksum);
+        }
+        g_free(source_path);
+        g_free(dest_path);
+
+        if (result == Copied) {
+            if (flags & G_FILE_COPY_ALL_METADATA)
+                g_file_copy_attributes(source, destination, flags, cancellable, nullptr);
+            return true;
+        }
+        if (result == Failed)
+            return false;
+    }
+
+    return copy(source, destination, flags, cancellable,
+                progress_callback, progress_callback_data, error, checksum);
+}
+
+FileCopyEngine::NativeResult FileCopyEngine::journaledCopy(GFile *source,
+                                                           GFile *destination,
+                                                           const char *source_path,
+                                                           const char *dest_path,
+                                                           GFileCopyFlags flags,
+                                                           GCancellable *cancellable,
+                                                           GFileProgressCallback progress_callback,
+                                                           gpointer progress_callback_data,
+                                                           GError **error,
+                                                           FileChecksum *checksum)
+{
+    struct stat source_stat;
+    int ret = (flags & G_FILE_COPY_NOFOLLOW_SYMLINKS)? lstat(source_path, &source_stat): stat(source_path, &source_stat);
+    if (ret != 0 || !S_ISREG(source_stat.st_mode) || source_stat.st_size < JOURNAL_MIN_SIZE)
+        return Unsupported;
+
+    char *source_uri = g_file_get_uri(source);
+    char *dest_uri = g_file_get_uri(destination);
+    bool journaled = FileTransferJournal::exists(source_uri, dest_uri);
+    FileTransferJournal journal(source_uri, dest_uri);
+    g_free(source_uri);
+    g_free(dest_uri);
+
+    int source_fd = open(source_path, O_RDONLY|O_CLOEXEC);
+    if (source_fd < 0)
+        return Unsupported;
+
+    //a partial target of an unfinished transfer is resumed, not a conflict.
+    //only the target created by the journal is resumed or truncated, the
+    //others are replaced by the normal copy.
+    goffset total = source_stat.st_size;
+    goffset offset = 0;
+    int dest_fd = open(dest_path, O_RDWR|O_NOFOLLOW|O_CLOEXEC);
+    if (dest_fd >= 0) {
+        struct stat dest_stat;
+        if (!journaled || fstat(dest_fd, &dest_stat) != 0 || !S_ISREG(dest_stat.st_mode) ||
+                (dest_stat.st_dev == source_stat.st_dev && dest_stat.st_ino == source_stat.st_ino)) {
+            close(dest_fd);
+            close(source_fd);
+            return Unsupported;
+        }
+        offset = journal.resumeOffset(dest_fd, total, source_stat.st_mtime);
+    } else if (errno == ENOENT) {
+        dest_fd = open(dest_path, O_RDWR|O_CREAT|O_EXCL|O_NOFOLLOW|O_CLOEXEC, source_stat.st_mode & 0777);
+        if (dest_fd < 0) {
+            close(source_fd);
+            return Unsupported;
+        }
+    } else {
+        //such as a symbolic link.
+        close(source_fd);
+        return Unsupported;
+    }
+    if (offset == 0 && (ftruncate(dest_fd, 0) != 0 || !journal.begin(total, source_stat.st_mtime))) {
+        close(dest_fd);
+        close(source_fd);
+        return Unsupported;
+    }
+
+    if (progress_callback)
+        progress_callback(offset, total, progress_callback_data);
+    //the resumed part is not hashed, it has to be read again for verifying.
+    if (offset > 0)
+        checksum = nullptr;
+
+    char *buffer = static_cast<char *>(g_malloc(JOURNAL_CHUNK_SIZE));
+    int err_code = 0;
+    while (offset < total) {
+        if (g_cancellable_is_cancelled(cancellable)) {
+            err_code = ECANCELED;
+            break;
+        }
+
+        qint64 length = qMin<qint64>(JOURNAL_CHUNK_SIZE, total - offset);
+        qint64 done = 0;
+        while (err_code == 0 && done < length) {
+            ssize_t read_size = pread(source_fd, buffer + done, size_t(length - done), off_t(offset + done));
+            if (read_size <= 0)
+                err_code = read_size < 0? errno: EIO;
+            else
+                done += read_size;
+        }
+        done = 0;
+        while (err_code == 0 && done < length) {
+            ssize_t written = pwrite(dest_fd, buffer + done, size_t(length - done), off_t(offset + done));
+            if (written <= 0)
+                err_code = written < 0? errno: EIO;
+            else
+                done += written;
+        }
+        //the chunk must be on the target before it is recorded.
+        if (err_code == 0 && fdatasync(dest_fd) != 0)
+            err_code = errno;
+        if (err_code != 0)
+            break;
+
+        journal.commitChunk(offset, length, FileTransferJournal::chunkChecksum(buffer, length));
+        if (checksum)
+            checksum->update(buffer, length);
+        if (s_cache_dropped.load()) {
+            //the chunk has been synced, it could be dropped.
+            posix_fadvise(source_fd, off_t(offset), off_t(length), POSIX_FADV_DONTNEED);
+            posix_fadvise(dest_fd, off_t(offset), off_t(length), POSIX_FADV_DONTNEED);
+        }
+        offset += length;
+        if (progress_callback)
+            progress_callback(offset, total, progress_callback_data);
+    }
+    g_free(buffer);
+
+    close(source_fd);
+    if (err_code == 0 && ftruncate(dest_fd, total) != 0)
+        err_code = errno;
+    if (close(dest_fd) != 0 && err_code == 0)
+        err_code = errno;
+
+    if (err_code == 0) {
+        journal.finish();
+        if (checksum)
+            checksum->setComplete();
+        return Copied;
+    }
+
+    //keep the partial target and journal for resuming.
+    if (err_code == ECANCELED) {
+        g_set_error_literal(error, G_IO_ERROR, G_IO_ERROR_CANCELLED, "Operation was cancelled");
+    } else {
+        g_set_error_literal(error, G_IO_ERROR, g_io_error_from_errno(err_code), g_strerror(err_code));
+    }
+    return Failed;
+}
+
+/*!
+ * \brief dropCachedTarget
+ * <br>
+ * Flush the target and drop its pages, so that it is read back from the device
+ * rather than the page cache it was just written into.
+ * </br>
+ */
+static void dropCachedTarget(GFile *destination)
+{
+    char *dest_path = g_file_get_path(destination);
+    if (!dest_path)
+        return;
+
+    int dest_fd = open(dest_path, O_RDONLY|O_NOFOLLOW|O_CLOEXEC);
+    g_free(dest_path);
+    if (dest_fd < 0)
+        return;
+
+    //the dirty pages can not be dropped, write them first.
+    fdatasync(dest_fd);
+    posix_fadvise(dest_fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(dest_fd);
+}
+
+bool FileCopyEngine::verify(GFile *source,
+                            GFile *destination,
+                            FileChecksum *sourceChecksum,
+                            GCancellable *cancellable,
+                            GError **error)
+{
+    //only the data of regular files are compared.
+    GFileInfo *info = g_file_query_info(source, G_FILE_ATTRIBUTE_STANDARD_TYPE,
+                                        G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, cancellable, nullptr);
+    bool regular = info && g_file_info_get_file_type(info) == G_FILE_TYPE_REGULAR;
+    if (info)
+        g_object_unref(info);
+    if (!regular)
+        return true;
+
+    dropCachedTarget(destination);
+
+    FileChecksum computedChecksum;
+    FileChecksum destChecksum;
+    GError *source_error = nullptr;
+    GError *dest_error = nullptr;
+    if (!sourceChecksum || !sourceChecksum->isComplete()) {
+        //hash the source and target at the same time, they are usually
+        //on different devices.
+        sourceChecksum = &computedChecksum;
+        QThreadPool pool;
+        pool.setMaxThreadCount(1);
+        pool.start(new FileHashJob(source, sourceChecksum, cancellable, &source_error));
+        FileChecksum::hashFile(destination, &destChecksum, cancellable, &dest_error);
+        pool.waitForDone();
+    } else {
+        FileChecksum::hashFile(destination, &destChecksum, cancellable, &dest_error);
+    }
+
+    if (g_cancellable_set_error_if_cancelled(cancellable, error)) {
+        g_clear_error(&source_error);
+        g_clear_error(&dest_error);
+        return false;
+    }
+
+    //a file could not be read, it is not known whether the target is broken.
+    if (dest_error) {
+        g_clear_error(&source_error);
+        g_propagate_error(error, dest_error);
+        return false;
+    }
+    if (source_error) {
+        g_propagate_error(error, source_error);
+        return false;
+    }
+
+    if (sourceChecksum->isComplete() && destChecksum.isComplete() &&
+            sourceChecksum->length() == destChecksum.length() &&
+            sourceChecksum->digest() == destChecksum.digest()) {
+        return true;
+    }
+
+    //do not leave a broken copy.
+    g_file_delete(destination, nullptr, nullptr);
+    char *dest_uri = g_file_get_uri(destination);
+    g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                "The copied file %s does not match the source", dest_uri);
+    g_free(dest_uri);
+    return false;
+}
@@ -0,0 +1,164 @@
+#ifndef FILECOPYENGINE_H
+#define FILECOPYENGINE_H
+
+#include "peony-core_global.h"
+#include <gio/gio.h>
+
+namespace Peony {
+
+class FileChecksum;
+
+/*!
+ * \brief The FileCopyEngine class
+ * <br>
+ * FileCopyEngine copies a file with the same interface as g_file_copy().
+ * For local regular files, it lets the kernel copy the data rather than
+ * the userspace read/write loop of gio. It tries FICLONE reflink first,
+ * which is a metadata operation on btrfs and xfs, then copy_file_range()
+ * and sendfile(), which copy the data in kernel.
+ * </br>
+ * <br>
+ * A large file which can not be cloned is copied in chunks by a reader and a
+ * writer overlapping on two buffers. The chunks copied are dropped from page
+ * cache, and O_DIRECT could be enabled, so that a huge transfer does not evict
+ * the working set of other applications. The buffer size and the threshold
+ * are tunable.
+ * </br>
+ * <br>
+ * If the native copy is not supported or it fails before writing any data,
+ * it falls back to g_file_copy(), so that the errors are reported by gio
+ * as before, such as the target exists.
+ * </br>
+ * \note
+ * The backup flag and the symbolic links are always handled by gio.
+ * \see FileCopyOperation, FileMoveOperation.
+ */
+class PEONYCORESHARED_EXPORT FileCopyEngine
+{
+public:
+    /*!
+     * \brief copy
+     * \param checksum, if it is not null, the source data is hashed into it when
+     * the data passes through the engine's buffers. It is marked complete if the
+     * whole source was hashed.
+     * \return true if the file was copied.
+     * \see g_file_copy(), verify().
+     */
+    static bool copy(GFile *source,
+                     GFile *destination,
+                     GFileCopyFlags flags,
+                     GCancellable *cancellable,
+                     GFileProgressCallback progress_callback,
+                     gpointer progress_callback_data,
+                     GError **error,
+                     FileChecksum *checksum = nullptr);
+
+    /*!
+     * \brief copyResumable
+     * \return true if the file was copied.
+     * <br>
+     * It is the same as copy(), but a large local file is copied in chunks with
+     * a FileTransferJournal. If the copy breaks, the partial target is kept and
+     * the next copy of the same file resumes from the last verified chunk, the
+     * existed partial target is not reported as a conflict.
+     * </br>
+     * \see FileTransferJournal.
+     */
+    static bool copyResumable(GFile *source,
+                              GFile *destination,
+                              GFileCopyFlags flags,
+                              GCancellable *cancellable,
+                              GFileProgressCallback progress_callback,
+                              gpointer progress_callback_data,
+                              GError **error,
+                              FileChecksum *checksum = nullptr);
+
+    /*!
+     * \brief verify
+     * \param sourceChecksum, the checksum computed while copying, the source is
+     * hashed again only if it is not complete.
+     * \return true if the target is the same as source.
+     * <br>
+     * The target is flushed and dropped from the page cache, then read back and hashed,
+     * in parallel with the source if it has to be hashed. A target which does not match
+     * is deleted, and a G_IO_ERROR_FAILED error is set. If a file could not be read, its
+     * error is set and the target is kept.
+     * </br>
+     */
+    static bool verify(GFile *source,
+                       GFile *destination,
+                       FileChecksum *sourceChecksum,
+                       GCancellable *cancellable,
+                       GError **error);
+
+    /*!
+     * \brief setChunkSize
+     * \param size, the size of each buffer of chunked copy, it is aligned to 4KiB.
+     */
+    static void setChunkSize(int size);
+    static int chunkSize();
+    /*!
+     * \brief setChunkedCopyThreshold
+     * \param size, the files not smaller than it are copied in chunks.
+     */
+    static void setChunkedCopyThreshold(qint64 size);
+    static qint64 chunkedCopyThreshold();
+    /*!
+     * \brief setDirectIO
+     * \param enabled, open the files of chunked copy with O_DIRECT if the file
+     * system supports it.
+     */
+    static void setDirectIO(bool enabled);
+    static bool isDirectIO();
+    /*!
+     * \brief setCacheDropped
+     * \param dropped, drop the copied chunks from page cache with posix_fadvise().
+     */
+    static void setCacheDropped(bool dropped);
+    static bool isCacheDropped();
+
+protected:
+    enum NativeResult {
+        Copied,
+        Failed,
+        Unsupported
+    };
+
+    static NativeResult nativeCopy(const char *source_path,
+                                   const char *dest_path,
+                                   GFileCopyFlags flags,
+                                   GCancellable *cancellable,
+                                   GFileProgressCallback progress_callback,
+                                   gpointer progress_callback_data,
+                                   GError **error,
+                                   FileChecksum *checksum);
+
+    /*!
+     * \brief chunkedCopy
+     * \param offset, the bytes copied.
+     * \return 0 or the errno.
+     */
+    static int chunkedCopy(int source_fd,
+                           int dest_fd,
+                           goffset total,
+                           goffset *offset,
+                           GCancellable *cancellable,
+                           GFileProgressCallback progress_callback,
+                           gpointer progress_callback_data,
+                           FileChecksum *checksum);
+
+    static NativeResult journaledCopy(GFile *source,
+                                      GFile *destination,
+                                      const char *source_path,
+                                      const char *dest_path,
+                                      GFileCopyFlags flags,
+                                      GCancellable *cancellable,
+                                      GFileProgressCallback progress_callback,
+                                      gpointer progress_callback_data,
+                                      GError **error,
+                                      FileChecksum *checksum);
+};
+
+}
+
+#endif // FILECOPYENGINE_H
@@ -2,27 +2,106 @@
 
 #include "file-node-reporter.h"
 #include "file-node.h"
+#include "file-node-scanner.h"
+#include "file-copy-engine.h"
+#include "file-transfer-journal.h"
+#include "file-checksum.h"
 #include "file-enumerator.h"
 #include "file-info.h"
 
 #include "file-operation-manager.h"
 
+#include <QThreadPool>
+#include <QThread>
+
 #include <QDebug>
 
+namespace Peony {
+
+/*!
+ * \brief The FileCopyJob class
+ * <br>
+ * A job of copying a file node in FileCopyOperation's copy pool.
+ * </br>
+ */
+class FileCopyJob : public QRunnable
+{
+public:
+    FileCopyJob(FileCopyOperation *operation, FileNode *node, const QString &destDirUri,
+                GFileHandle destFile = GFileHandle()) {
+        m_operation = operation;
+        m_node = node;
+        m_dest_dir_uri = destDirUri;
+        m_dest_file = std::move(destFile);
+    }
+
+    void run() override {
+        m_operation->copyFile(m_node, m_dest_dir_uri, std::move(m_dest_file));
+        m_operation->m_copy_slots.release();
+    }
+
+private:
+    FileCopyOperation *m_operation = nullptr;
+    FileNode *m_node = nullptr;
+    QString m_dest_dir_uri;
+    GFileHandle m_dest_file;
+};
+
+}
+
 using namespace Peony;
 
+/*!
+ * \brief isSourceNewer
+ * \return true if the source was modified after the target in dest dir,
+ * or the target does not exist.
+ */
+static bool isSourceNewer(const QString &srcUri, const QString &destDirUri)
+{
+    GFile *source = g_file_new_for_uri(srcUri.toUtf8().constData());
+    GFile *destDir = g_file_new_for_uri(destDirUri.toUtf8().constData());
+    char *name = g_file_get_basename(source);
+    GFile *target = g_file_get_child(destDir, name);
+    g_free(name);
+    g_object_unref(destDir);
+
+    GFileInfo *sourceInfo = g_file_query_info(source, G_FILE_ATTRIBUTE_TIME_MODIFIED,
+                                              G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, nullptr, nullptr);
+    GFileInfo *targetInfo = g_file_query_info(target, G_FILE_ATTRIBUTE_TIME_MODIFIED,
+                                              G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, nullptr, nullptr);
+    g_object_unref(source);
+    g_object_unref(target);
+
+    bool newer = true;
+    if (sourceInfo && targetInfo) {
+        newer = g_file_info_get_attribute_uint64(sourceInfo, G_FILE_ATTRIBUTE_TIME_MODIFIED) >
+                g_file_info_get_attribute_uint64(targetInfo, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+    }
+    if (sourceInfo)
+        g_object_unref(sourceInfo);
+    if (targetInfo)
+        g_object_unref(targetInfo);
+    return newer;
+}
+
 FileCopyOperation::FileCopyOperation(QStringList sourceUris, QString destDirUri, QObject *parent) : FileOperation (parent)
 {
     m_source_uris = sourceUris;
     m_dest_dir_uri = destDirUri;
     m_reporter = new FileNodeReporter;
-    connect(m_reporter, &FileNodeReporter::nodeFound, this, &FileOperation::operationPreparedOne);
+    //the nodes are found in operation thread, do not queue the signal to ui thread.
+    connect(m_reporter, &FileNodeReporter::nodeFound, this, &FileOperation::operationPreparedOne, Qt::DirectConnection);
 
     m_info = std::make_shared<FileOperationInfo>(sourceUris, destDirUri, FileOperationInfo::Copy);
+    m_dest_dir_file.reset(g_file_new_for_uri(destDirUri.toUtf8().constData()));
+
+    m_copy_pool = new QThreadPool;
 }
 
 FileCopyOperation::~FileCopyOperation()
 {
+    m_copy_pool->waitForDone();
+    delete m_copy_pool;
     delete m_reporter;
 }
 
@@ -34,12 +113,143 @@ FileOperation::ResponseType FileCopyOperation::prehandle(GError *err)
     return Other;
 }
 
+FileOperation::ResponseType FileCopyOperation::handleError(const GErrorWrapperPtr &err, const QString &srcUri, const QString &destDirUri)
+{
+    if (isCancelled())
+        return Cancel;
+
+    m_error_mutex.lock();
+    ResponseType handle_type = m_prehandle_hash.value(err->code(), Other);
+    m_error_mutex.unlock();
+    if (handle_type == Other) {
+        //the errors are responded one by one, only the jobs which need
+        //a response wait for the dialog.
+        QMutexLocker responseLocker(&m_response_mutex);
+        if (isCancelled())
+            return Cancel;
+
+        //it might have been responded for all while waiting.
+        m_error_mutex.lock();
+        handle_type = m_prehandle_hash.value(err->code(), Other);
+        m_error_mutex.unlock();
+        if (handle_type == Other) {
+            auto typeData = errored(srcUri, destDirUri, err);
+            handle_type = typeData.value<ResponseType>();
+
+            QMutexLocker locker(&m_error_mutex);
+            switch (handle_type) {
+            case IgnoreAll:
+                m_prehandle_hash.insert(err->code(), IgnoreOne);
+                break;
+            case OverWriteAll:
+                m_prehandle_hash.insert(err->code(), OverWriteOne);
+                break;
+            case BackupAll:
+                m_prehandle_hash.insert(err->code(), BackupOne);
+                break;
+            default:
+                break;
+            }
+        }
+    }
+
+    switch (handle_type) {
+    case IgnoreAll:
+        return IgnoreOne;
+    case OverWriteAll:
+        return OverWriteOne;
+    case BackupAll:
+        return BackupOne;
+    case OverWriteNewer:
+        return isSourceNewer(srcUri, destDirUri)? OverWriteOne: IgnoreOne;
+    default:
+        return handle_type;
+    }
+}
+
+bool FileCopyOperation::deferError(const GErrorWrapperPtr &err, FileNode *node, const QString &destDirUri)
+{
+    if (!isConflictsDeferred() || m_resolving_conflicts)
+        return false;
+
+    QMutexLocker locker(&m_error_mutex);
+    //the error has been responded for all.
+    if (m_prehandle_hash.contains(err->code()))
+        return false;
+
+    FileOperationConflict conflict;
+    conflict.srcUri = node->uri();
+    conflict.destDirUri = destDirUri;
+    conflict.err = err;
+    m_conflicts<<conflict;
+    m_conflict_nodes<<node;
+    return true;
+}
+
+void FileCopyOperation::resolveConflicts()
+{
+    auto rulesData = conflictsDeferred(m_conflicts);
+    auto rules = rulesData.value<ConflictRules>();
+
+    m_error_mutex.lock();
+    for (auto code : rules.keys()) {
+        switch (rules.value(code)) {
+        case IgnoreOne:
+        case IgnoreAll:
+            m_prehandle_hash.insert(code, IgnoreOne);
+            break;
+        case OverWriteOne:
+        case OverWriteAll:
+            m_prehandle_hash.insert(code, OverWriteOne);
+            break;
+        case BackupOne:
+        case BackupAll:
+            m_prehandle_hash.insert(code, BackupOne);
+            break;
+        case OverWriteNewer:
+            m_prehandle_hash.insert(code, OverWriteNewer);
+            break;
+        case Cancel:
+            cancel();
+            break;
+        default:
+            //retry, the error will be handled one by one if it happens again.
+            break;
+        }
+    }
+    m_error_mutex.unlock();
+
+    //the parked files are copied again, they are not handled yet.
+    //a parked folder is created again in this thread with its held children.
+    m_resolving_conflicts = true;
+    m_held_folders.clear();
+    for (int i = 0; i < m_conflict_nodes.count(); i++) {
+        if (isCancelled())
+            break;
+        if (m_conflict_nodes.at(i)->isFolder()) {
+            copyRecursively(m_conflict_nodes.at(i));
+            continue;
+        }
+        m_copy_slots.acquire();
+        if (isCancelled()) {
+            m_copy_slots.release();
+            break;
+        }
+        m_copy_pool->start(new FileCopyJob(this, m_conflict_nodes.at(i), m_conflicts.at(i).destDirUri));
+    }
+    m_copy_pool->waitForDone();
+    m_resolving_conflicts = false;
+
+    m_conflicts.clear();
+    m_conflict_nodes.clear();
+}
+
 void FileCopyOperation::progress_callback(goffset current_num_bytes,
                                           goffset total_num_bytes,
-                                          FileCopyOperation *p_this)
+                                          CopyProgressData *data)
 {
-    Q_EMIT p_this->FileProgressCallback(p_this->m_current_src_uri,
-                                        p_this->m_current_dest_dir_uri,
+    data->operation->reportFileProgress(data->srcUri,
+                                        data->destDirUri,
                                         current_num_bytes,
                                         total_num_bytes);
 }
@@ -49,201 +259,238 @@ void FileCopyOperation::copyRecursively(FileNode *node)
     if (isCancelled())
         return;
 
-    QString relativePath = node->getRelativePath();
-    //FIXME: the smart pointers' deconstruction spends too much time.
-    GFileWrapperPtr destRoot = wrapGFile(g_file_new_for_uri(m_dest_dir_uri.toUtf8().constData()));
-    GFileWrapperPtr destFile = wrapGFile(g_file_resolve_relative_path(destRoot.get()->get(),
-                                                                      relativePath.toUtf8().constData()));
-
-    char *dest_file_uri = g_file_get_uri(destFile.get()->get());
-    node->setDestUri(dest_file_uri);
-    g_free(dest_file_uri);
-    m_current_src_uri = node->uri();
-    GFile *dest_parent = g_file_get_parent(destFile.get()->get());
-    char *dest_dir_uri = g_file_get_uri(dest_parent);
-    m_current_dest_dir_uri = dest_dir_uri;
-    g_free(dest_dir_uri);
-    g_object_unref(dest_parent);
+    copyNode(node);
+    for (auto child : *(node->children())) {
+        copyRecursively(child);
+    }
+}
+
+void FileCopyOperation::copyNode(FileNode *node)
+{
+    if (isCancelled())
+        return;
+
+    //the children of a parked folder wait for its conflict resolved.
+    if (!m_resolving_conflicts && node->parent() && m_held_folders.contains(node->parent())) {
+        if (node->isFolder())
+            m_held_folders<<node;
+        return;
+    }
+
+    QString destDirUri;
+    GFileHandle destFile;
+    if (node->parent()) {
+        //the dest uri of a child is built from its parent's.
+        destDirUri = node->parent()->destUri();
+        destFile.reset(g_file_new_for_uri(node->destUri().toUtf8().constData()));
+    } else {
+        QString relativePath = node->getRelativePath();
+        destFile.reset(g_file_resolve_relative_path(m_dest_dir_file.get(), relativePath.toUtf8().constData()));
+
+        char *dest_file_uri = g_file_get_uri(destFile.get());
+        node->setDestUri(dest_file_uri);
+        g_free(dest_file_uri);
+        GFileHandle destParent(g_file_get_parent(destFile.get()));
+        char *dest_dir_uri = g_file_get_uri(destParent.get());
+        destDirUri = dest_dir_uri;
+        g_free(dest_dir_uri);
+    }
+
+    if (!node->isFolder()) {
+        //wait for a free slot, the slot is released when the job finished.
+        m_copy_slots.acquire();
+        if (isCancelled()) {
+            m_copy_slots.release();
+            return;
+        }
+        //the dest file is passed to the job, it need not be created again.
+        m_copy_pool->start(new FileCopyJob(this, node, destDirUri, std::move(destFile)));
+        return;
+    }
 
 fallback_retry:
-    if (node->isFolder()) {
-        GError *err = nullptr;
-
-        //NOTE: mkdir doesn't have a progress callback.
-        g_file_make_directory(destFile.get()->get(),
-                              getCancellable().get()->get(),
-                              &err);
-        if (err) {
-            if (err->code == G_IO_ERROR_CANCELLED) {
-                return;
-            }
-            auto errWrapperPtr = GErrorWrapper::wrapFrom(err);
-            ResponseType handle_type = prehandle(err);
-            if (handle_type == Other) {
-                qDebug()<<"send error";
-                auto typeData = errored(m_current_src_uri, m_current_dest_dir_uri, errWrapperPtr);
-                qDebug()<<"get return";
-                handle_type = typeData.value<ResponseType>();
-            }
-            //handle.
-            switch (handle_type) {
-            case IgnoreOne: {
-                node->setState(FileNode::Unhandled);
-                node->setErrorResponse(IgnoreOne);
-                break;
-            }
-            case IgnoreAll: {
-                node->setState(FileNode::Unhandled);
-                node->setErrorResponse(IgnoreOne);
-                m_prehandle_hash.insert(err->code, IgnoreOne);
-                break;
-            }
-            case OverWriteOne: {
-                node->setState(FileNode::Handled);
-                node->setErrorResponse(OverWriteOne);
-                //make dir has no overwrite
-                break;
-            }
-            case OverWriteAll: {
-                node->setState(FileNode::Handled);
-                node->setErrorResponse(OverWriteOne);
-                m_prehandle_hash.insert(err->code, OverWriteOne);
-                break;
-            }
-            case BackupOne: {
-                node->setState(FileNode::Handled);
-                node->setErrorResponse(BackupOne);
-                //make dir has no backup
-                break;
-            }
-            case BackupAll: {
-                node->setState(FileNode::Handled);
-                node->setErrorResponse(BackupOne);
-                //make dir has no backup
-                m_prehandle_hash.insert(err->code, BackupOne);
-                break;
-            }
-            case Retry: {
-                goto fallback_retry;
-            }
-            case Cancel: {
-                cancel();
-                break;
-            }
-            default:
-                break;
-            }
-        } else {
+    GError *err = nullptr;
+
+    //NOTE: mkdir doesn't have a progress callback.
+    g_file_make_directory(destFile.get(),
+                          getCancellable().get()->get(),
+                          &err);
+    if (err) {
+        auto errWrapperPtr = GErrorWrapper::wrapFrom(err);
+        if (err->code == G_IO_ERROR_CANCELLED) {
+            return;
+        }
+        if (deferError(errWrapperPtr, node, destDirUri)) {
+            //the folder and its children will be copied again when the conflicts resolved.
+            m_held_folders<<node;
+            return;
+        }
+        ResponseType handle_type = handleError(errWrapperPtr, node->uri(), destDirUri);
+        //handle.
+        switch (handle_type) {
+        case IgnoreOne: {
+            node->setState(FileNode::Unhandled);
+            node->setErrorResponse(IgnoreOne);
+            break;
+        }
+        case OverWriteOne: {
+            node->setState(FileNode::Handled);
+            node->setErrorResponse(OverWriteOne);
+            //make dir has no overwrite
+            break;
+        }
+        case BackupOne: {
             node->setState(FileNode::Handled);
+            node->setErrorResponse(BackupOne);
+            //make dir has no backup
+            break;
+        }
+        case Retry: {
+            goto fallback_retry;
         }
-        //assume that make dir finished anyway
-        Q_EMIT operationProgressedOne(node->uri(), node->destUri(), node->size());
-        for (auto child : *(node->children())) {
-            copyRecursively(child);
+        case Cancel: {
+            cancel();
+            break;
+        }
+        default:
+            break;
         }
     } else {
-        GError *err = nullptr;
-        GFileWrapperPtr sourceFile = wrapGFile(g_file_new_for_uri(node->uri().toUtf8().constData()));
-        g_file_copy(sourceFile.get()->get(),
-                    destFile.get()->get(),
-                    m_default_copy_flag,
-                    getCancellable().get()->get(),
-                    GFileProgressCallback(progress_callback),
-                    this,
-                    &err);
-
-        if (err) {
-            if (err->code == G_IO_ERROR_CANCELLED) {
-                return;
-            }
-            auto errWrapperPtr = GErrorWrapper::wrapFrom(err);
-            ResponseType handle_type = prehandle(err);
-            if (handle_type == Other) {
-                qDebug()<<"send error";
-                auto typeData = errored(m_current_src_uri, m_current_dest_dir_uri, errWrapperPtr);
-                qDebug()<<"get return";
-                handle_type = typeData.value<ResponseType>();
-            }
-            //handle.
-            switch (handle_type) {
-            case IgnoreOne: {
-                node->setState(FileNode::Unhandled);
-                node->setErrorResponse(IgnoreOne);
-                break;
-            }
-            case IgnoreAll: {
-                node->setState(FileNode::Unhandled);
-                node->setErrorResponse(IgnoreOne);
-                m_prehandle_hash.insert(err->code, IgnoreOne);
-                break;
-            }
-            case OverWriteOne: {
-                g_file_copy(sourceFile.get()->get(),
-                            destFile.get()->get(),
-                            GFileCopyFlags(m_default_copy_flag | G_FILE_COPY_OVERWRITE),
-                            getCancellable().get()->get(),
-                            GFileProgressCallback(progress_callback),
-                            this,
-                            nullptr);
-                node->setState(FileNode::Handled);
-                node->setErrorResponse(OverWriteOne);
-                break;
-            }
-            case OverWriteAll: {
-                g_file_copy(sourceFile.get()->get(),
-                            destFile.get()->get(),
-                            GFileCopyFlags(m_default_copy_flag | G_FILE_COPY_OVERWRITE),
-                            getCancellable().get()->get(),
-                            GFileProgressCallback(progress_callback),
-                            this,
-                            nullptr);
-                node->setState(FileNode::Handled);
+        node->setState(FileNode::Handled);
+    }
+
+    //assume that make dir finished anyway
+    Q_EMIT operationProgressedOne(node->uri(), node->destUri(), node->size());
+}
+
+void FileCopyOperation::copyFile(FileNode *node, const QString &destDirUri, GFileHandle destFile)
+{
+    if (isCancelled())
+        return;
+
+    CopyProgressData data;
+    data.operation = this;
+    data.srcUri = node->uri();
+    data.destDirUri = destDirUri;
+
+    GFileHandle sourceFile(g_file_new_for_uri(node->uri().toUtf8().constData()));
+    if (!destFile)
+        destFile.reset(g_file_new_for_uri(node->destUri().toUtf8().constData()));
+    GFileCopyFlags flags = m_default_copy_flag;
+
+    auto copy = isJournaled()? FileCopyEngine::copyResumable: FileCopyEngine::copy;
+    FileChecksum checksum;
+
+fallback_retry:
+    GError *err = nullptr;
+    checksum.reset();
+    bool copied = copy(sourceFile.get(),
+                       destFile.get(),
+                       flags,
+                       getCancellable().get()->get(),
+                       GFileProgressCallback(progress_callback),
+                       &data,
+                       &err,
+                       isVerified()? &checksum: nullptr);
+    //a target which does not match is handled as the other errors.
+    if (copied && isVerified())
+        FileCopyEngine::verify(sourceFile.get(), destFile.get(), &checksum, getCancellable().get()->get(), &err);
+
+    if (err) {
+        auto errWrapperPtr = GErrorWrapper::wrapFrom(err);
+        if (err->code == G_IO_ERROR_CANCELLED) {
+            return;
+        }
+        if (deferError(errWrapperPtr, node, destDirUri)) {
+            //the node will be copied again when the conflicts resolved.
+            return;
+        }
+        ResponseType handle_type = handleError(errWrapperPtr, node->uri(), destDirUri);
+        //handle.
+        switch (handle_type) {
+        case IgnoreOne: {
+            node->setState(FileNode::Unhandled);
+            node->setErrorResponse(IgnoreOne);
+            break;
+        }
+        case OverWriteOne: {
+            //the overwriting might fail with another error, handle it as well.
+            if (!(flags & G_FILE_COPY_OVERWRITE)) {
+                flags = GFileCopyFlags(m_default_copy_flag | G_FILE_COPY_OVERWRITE);
                 node->setErrorResponse(OverWriteOne);
-                m_prehandle_hash.insert(err->code, OverWriteOne);
-                break;
-            }
-            case BackupOne: {
-                g_file_copy(sourceFile.get()->get(),
-                            destFile.get()->get(),
-                            GFileCopyFlags(m_default_copy_flag | G_FILE_COPY_BACKUP),
-                            getCancellable().get()->get(),
-                            GFileProgressCallback(progress_callback),
-                            this,
-                            nullptr);
-                node->setState(FileNode::Handled);
-                node->setErrorResponse(BackupOne);
-                break;
+                goto fallback_retry;
             }
-            case BackupAll: {
-                g_file_copy(sourceFile.get()->get(),
-                            destFile.get()->get(),
-                            GFileCopyFlags(m_default_copy_flag | G_FILE_COPY_BACKUP),
-                            getCancellable().get()->get(),
-                            GFileProgressCallback(progress_callback),
-                            this,
-                            nullptr);
-                node->setState(FileNode::Handled);
+            node->setState(FileNode::Unhandled);
+            break;
+        }
+        case BackupOne: {
+            if (!(flags & G_FILE_COPY_BACKUP)) {
+                flags = GFileCopyFlags(m_default_copy_flag | G_FILE_COPY_BACKUP);
                 node->setErrorResponse(BackupOne);
-                m_prehandle_hash.insert(err->code, BackupOne);
-                break;
-            }
-            case Retry: {
                 goto fallback_retry;
             }
-            case Cancel: {
-                cancel();
-                break;
-            }
-            default:
-                break;
-            }
-        } else {
-            node->setState(FileNode::Handled);
+            node->setState(FileNode::Unhandled);
+            break;
         }
-        Q_EMIT operationProgressedOne(node->uri(), node->destUri(), node->size());
+        case Retry: {
+            goto fallback_retry;
+        }
+        case Cancel: {
+            cancel();
+            break;
+        }
+        default:
+            break;
+        }
+    } else {
+        node->setState(FileNode::Handled);
     }
-    destFile.reset();
-    destRoot.reset();
+
+    Q_EMIT operationProgressedOne(node->uri(), node->destUri(), node->size());
+}
+
+int FileCopyOperation::computeMaxCopyCount()
+{
+    if (m_source_uris.isEmpty())
+        return 1;
+
+    //0: removable, 1: unknown, 2: local, 3: remote.
+    auto fsClass = [=](const QString &uri) -> int {
+        GFile *file = g_file_new_for_uri(uri.toUtf8().constData());
+        bool native = g_file_is_native(file);
+        GFileInfo *info = g_file_query_filesystem_info(file,
+                                                       G_FILE_ATTRIBUTE_FILESYSTEM_TYPE ","
+                                                       G_FILE_ATTRIBUTE_FILESYSTEM_REMOTE,
+                                                       nullptr,
+                                                       nullptr);
+        g_object_unref(file);
+        if (!native)
+            return 3;
+        if (!info)
+            return 1;
+
+        QString type = g_file_info_get_attribute_string(info, G_FILE_ATTRIBUTE_FILESYSTEM_TYPE);
+        bool remote = g_file_info_get_attribute_boolean(info, G_FILE_ATTRIBUTE_FILESYSTEM_REMOTE);
+        g_object_unref(info);
+        if (remote || type == "nfs" || type == "nfs4" || type == "cifs" || type == "smb2")
+            return 3;
+        if (type == "msdos" || type == "vfat" || type == "exfat" || type == "ntfs" || type == "fuseblk")
+            return 0;
+        if (type == "ext2" || type == "ext3" || type == "ext4" || type == "xfs" ||
+                type == "btrfs" || type == "f2fs" || type == "tmpfs")
+            return 2;
+        return 1;
+    };
+
+    int srcClass = fsClass(m_source_uris.first());
+    int destClass = fsClass(m_dest_dir_uri);
+    if (srcClass == 0 || destClass == 0)
+        return 2;
+    if (srcClass == 3 || destClass == 3)
+        return 8;
+    if (srcClass == 2 && destClass == 2)
+        return qBound(2, QThread::idealThreadCount(), 8);
+    return 2;
 }
 
 void FileCopyOperation::rollbackNodeRecursively(FileNode *node)
@@ -270,7 +517,9 @@ void FileCopyOperation::rollbackNodeRecursively(FileNode *node)
                 e.setEnumerateDirectory(node->destUri());
                 e.enumerateSync();
                 for (auto folder_child : *node->children()) {
-                    if (!folder_child->destUri().isEmpty()) {
+                    //keep the partial file for resuming.
+                    if (!folder_child->destUri().isEmpty() &&
+                            !FileTransferJournal::exists(folder_child->uri(), folder_child->destUri())) {
                         GFile *tmp_file = g_file_new_for_uri(folder_child->destUri().toUtf8().constData());
                         g_file_delete(tmp_file, nullptr, nullptr);
                         g_object_unref(tmp_file);
@@ -309,23 +558,64 @@ void FileCopyOperation::run()
 
     Q_EMIT operationRequestShowWizard();
 
+    int maxCopyCount = computeMaxCopyCount();
+    m_copy_pool->setMaxThreadCount(maxCopyCount);
+    m_copy_slots.release(2*maxCopyCount);
+
     goffset *total_size = new goffset(0);
 
     QList<FileNode*> nodes;
-    for (auto uri : m_source_uris) {
-        FileNode *node = new FileNode(uri, nullptr, m_reporter);
-        node->findChildrenRecursively();
-        node->computeTotalSize(total_size);
-        nodes<<node;
+    if (isPipelinedInto(m_source_uris, m_dest_dir_uri)) {
+        //copy the nodes as soon as they are found.
+        FileNodeScanner scanner(m_reporter, true);
+        for (auto uri : m_source_uris) {
+            FileNode *node = new FileNode(uri, nullptr, m_reporter);
+            scanner.start(node);
+            nodes<<node;
+        }
+        Q_EMIT operationPrepared();
+
+        while (FileNode *node = scanner.takeNode()) {
+            if (isCancelled()) {
+                scanner.cancel();
+                break;
+            }
+            copyNode(node);
+        }
+        //the trees must be completed before rollback.
+        scanner.waitForFinished();
+        for (auto node : nodes) {
+            node->computeTotalSize(total_size);
+        }
+    } else {
+        for (auto uri : m_source_uris) {
+            FileNode *node = new FileNode(uri, nullptr, m_reporter);
+            node->findChildrenRecursively();
+            node->computeTotalSize(total_size);
+            nodes<<node;
+        }
+        Q_EMIT operationPrepared();
+
+        for (auto node : nodes) {
+            copyRecursively(node);
+        }
     }
-    Q_EMIT operationPrepared();
 
     m_total_szie = *total_size;
     delete total_size;
 
-    for (auto node : nodes) {
-        copyRecursively(node);
+    //the folders which could not be enumerated are not copied completely.
+    for (auto error : m_reporter->takeEnumerateErrors()) {
+        if (handleError(error.second, error.first, m_dest_dir_uri) == Cancel) {
+            cancel();
+            break;
+        }
     }
+
+    //the nodes are used by jobs, they must be finished before rollback.
+    m_copy_pool->waitForDone();
+    if (!m_conflicts.isEmpty() && !isCancelled())
+        resolveConflicts();
     Q_EMIT operationProgressed();
 
     if (isCancelled()) {
@@ -5,13 +5,33 @@
 
 #include "file-operation.h"
 
+#include <QMutex>
+#include <QSemaphore>
+#include <QSet>
+
+class QThreadPool;
+
 namespace Peony {
 
 class FileNodeReporter;
 class FileNode;
-
+class FileCopyJob;
+
+/*!
+ * \brief The FileCopyOperation class
+ * <br>
+ * The folders are created in the operation's thread before their children,
+ * and the files are copied by a bounded pool of concurrent jobs, so that
+ * copying lots of small files could keep the devices and the link busy.
+ * </br>
+ * \note
+ * The error handling is serialized, there is only one error shown at the same
+ * time, and the response for all is shared by the jobs.
+ * \see FileCopyJob.
+ */
 class PEONYCORESHARED_EXPORT FileCopyOperation : public FileOperation
 {
+    friend class FileCopyJob;
     Q_OBJECT
 public:
     explicit FileCopyOperation(QStringList sourceUris, QString destDirUri, QObject *parent = nullptr);
@@ -20,17 +40,105 @@ public:
     void run() override;
     std::shared_ptr<FileOperationInfo> getOperationInfo() override {return m_info;}
 
+    /*!
+     * \brief setVerified
+     * \param verified
+     * \details
+     * In verified mode, every file copied is read back and compared with its source
+     * by XXH64 digest. The source is hashed while it is copied when the data passes
+     * through the copy engine, otherwise it is hashed in parallel with the target.
+     * A target which does not match is deleted and reported by errored().
+     * \see FileCopyEngine::verify().
+     */
+    void setVerified(bool verified = true) {m_verified = verified;}
+    bool isVerified() {return m_verified;}
+
 protected:
     ResponseType prehandle(GError *err);
+    /*!
+     * \brief handleError
+     * \param err
+     * \param srcUri
+     * \param destDirUri
+     * \return the response of error, the response for all has been recorded
+     * and converted to the response for one.
+     * <br>
+     * This might be called by several jobs at the same time, it is serialized
+     * and looks up the prehandle hash again after lock, for the error might
+     * have been responded for all while waiting.
+     * </br>
+     */
+    ResponseType handleError(const GErrorWrapperPtr &err, const QString &srcUri, const QString &destDirUri);
+    /*!
+     * \brief deferError
+     * \param err
+     * \param node, the file node which failed.
+     * \param destDirUri
+     * \return true if the node was parked in the conflict queue.
+     * <br>
+     * In deferred-conflict mode, a failed file is parked rather than handled at once,
+     * unless its error has been responded for all.
+     * </br>
+     * \see resolveConflicts().
+     */
+    bool deferError(const GErrorWrapperPtr &err, FileNode *node, const QString &destDirUri);
+    /*!
+     * \brief resolveConflicts
+     * <br>
+     * Ask for the rules of parked conflicts in bulk, and copy the parked files again
+     * with the rules as the prehandled responses.
+     * </br>
+     */
+    void resolveConflicts();
+
+    struct CopyProgressData {
+        FileCopyOperation *operation = nullptr;
+        QString srcUri;
+        QString destDirUri;
+    };
     static void progress_callback(goffset current_num_bytes,
                                   goffset total_num_bytes,
-                                  FileCopyOperation *p_this);
+                                  CopyProgressData *data);
     /*!
      * \brief copyRecursively
      * \param node
+     * <br>
+     * Create the folders and start the file copy jobs in the order of tree.
+     * </br>
      * \see FileMoveOperation::copyRecursively()
      */
     void copyRecursively(FileNode *node);
+    /*!
+     * \brief copyNode
+     * \param node
+     * <br>
+     * Create a folder, or start the copy job of a file. The parent node must
+     * have been handled.
+     * </br>
+     */
+    void copyNode(FileNode *node);
+    /*!
+     * \brief copyFile
+     * \param node, a file node whose dest uri has been set.
+     * \param destDirUri
+     * \param destFile, the dest file created by copyNode(), it is created from the
+     * node's dest uri if it is null.
+     * <br>
+     * Copy a file node, this is called in the copy pool's threads.
+     * </br>
+     */
+    void copyFile(FileNode *node, const QString &destDirUri, GFileHandle destFile = GFileHandle());
+    /*!
+     * \brief computeMaxCopyCount
+     * \return the count of concurrent copy jobs.
+     * <br>
+     * The count is tuned by the file system of source and destination.
+     * Removable devices formatted with fat or ntfs slow down with concurrent
+     * writing, local disks scale with a few jobs, and remote locations need
+     * more jobs for hiding the latency.
+     * </br>
+     */
+    int computeMaxCopyCount();
     /*!
      * \brief rollbackNodeRecursively
      * \param node
@@ -58,11 +166,15 @@ private:
 
     QStringList m_source_uris;
     QString m_dest_dir_uri = nullptr;
+    /*!
+     * \brief m_dest_dir_file
+     * \details
+     * The dest dir, it is shared by the copy jobs for resolving the roots' dest files.
+     */
+    GFileHandle m_dest_dir_file;
 
     int m_current_count = 0;
     int m_total_count = 0;
-    QString m_current_src_uri = nullptr;
-    QString m_current_dest_dir_uri = nullptr;
 
     goffset m_current_offset = 0;
     goffset m_total_szie = 0;
@@ -79,6 +191,44 @@ private:
      * for next prehandleing.
      */
     QHash<int, ResponseType> m_prehandle_hash;
+    QMutex m_error_mutex;
+    /*!
+     * \brief m_response_mutex
+     * \details
+     * The errors are responded one by one, it is held while waiting for the
+     * response. m_error_mutex is only held around the prehandle hash, so the
+     * jobs which do not need a response are not blocked by the dialog.
+     */
+    QMutex m_response_mutex;
+
+    /*!
+     * \brief m_conflicts
+     * \details
+     * The parked conflicts and their nodes in deferred-conflict mode, they are
+     * protected by m_error_mutex.
+     */
+    QList<FileOperationConflict> m_conflicts;
+    QList<FileNode*> m_conflict_nodes;
+    bool m_resolving_conflicts = false;
+    /*!
+     * \brief m_held_folders
+     * \details
+     * The parked folders and their sub folders, their children are not copied
+     * until the conflicts resolved. It is only used in operation thread.
+     */
+    QSet<FileNode*> m_held_folders;
+
+    /*!
+     * \brief m_copy_pool
+     * \details
+     * The pool of file copy jobs. m_copy_slots limits the count of started but
+     * not finished jobs, so that the operation will not queue all the files
+     * at once and it could stop in time when cancelled.
+     */
+    QThreadPool *m_copy_pool = nullptr;
+    QSemaphore m_copy_slots;
+
+    bool m_verified = false;
 
     std::shared_ptr<FileOperationInfo> m_info = nullptr;
 };
@@ -0,0 +1,256 @@
+#include "file-delete-engine.h"
+
+#include <QThreadPool>
+#include <QThread>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <errno.h>
+
+//report the progress every so many deleted files.
+#define PROGRESS_BATCH_SIZE 256
+
+namespace Peony {
+
+/*!
+ * \brief The FileDeleteTask struct
+ * <br>
+ * A directory being deleted. pending is the count of the directory's own scanning
+ * and its sub directories not removed yet, the directory is removed when it drops
+ * to 0.
+ * </br>
+ */
+struct FileDeleteTask {
+    QByteArray path;
+    FileDeleteTask *parent = nullptr;
+    QAtomicInt pending = 1;
+    QAtomicInt failed = 0;
+};
+
+/*!
+ * \brief The FileDeleteJob class
+ * <br>
+ * A job of deleting the entries of a directory in FileDeleteEngine's pool.
+ * </br>
+ */
+class FileDeleteJob : public QRunnable
+{
+public:
+    FileDeleteJob(FileDeleteEngine *engine, FileDeleteTask *task) {
+        m_engine = engine;
+        m_task = task;
+    }
+
+    void run() override {
+        m_engine->scanDirectory(m_task);
+    }
+
+private:
+    FileDeleteEngine *m_engine = nullptr;
+    FileDeleteTask *m_task = nullptr;
+};
+
+}
+
+using namespace Peony;
+
+FileDeleteEngine::FileDeleteEngine(GCancellable *cancellable)
+{
+    if (cancellable)
+        m_cancellable = G_CANCELLABLE(g_object_ref(cancellable));
+
+    m_pool = new QThreadPool;
+    //the unlinking is mostly waiting for the file system journal.
+    m_pool->setMaxThreadCount(qBound(2, QThread::idealThreadCount(), 8));
+}
+
+FileDeleteEngine::~FileDeleteEngine()
+{
+    m_pool->waitForDone();
+    delete m_pool;
+    if (m_cancellable)
+        g_object_unref(m_cancellable);
+}
+
+bool FileDeleteEngine::isSupported(const QString &uri)
+{
+    GFile *file = g_file_new_for_uri(uri.toUtf8().constData());
+    char *path = g_file_get_path(file);
+    bool supported = g_file_is_native(file) && path;
+    g_free(path);
+    g_object_unref(file);
+    return supported;
+}
+
+bool FileDeleteEngine::deleteUri(const QString &uri)
+{
+    GFile *file = g_file_new_for_uri(uri.toUtf8().constData());
+    char *c_path = g_file_get_path(file);
+    g_object_unref(file);
+    if (!c_path)
+        return false;
+    QByteArray path = c_path;
+    g_free(c_path);
+
+    m_failed.store(0);
+    addFound();
+
+    struct stat st;
+    if (lstat(path.constData(), &st) != 0) {
+        reportError(path, errno);
+    } else if (!S_ISDIR(st.st_mode)) {
+        if (unlink(path.constData()) == 0) {
+            addDeleted(path);
+        } else {
+            reportError(path, errno);
+        }
+    } else {
+        auto root = new FileDeleteTask;
+        root->path = path;
+        m_pool->start(new FileDeleteJob(this, root));
+        m_pool->waitForDone();
+    }
+
+    flushProgress();
+    return m_failed.load() == 0 && !isCancelled();
+}
+
+void FileDeleteEngine::scanDirectory(FileDeleteTask *task)
+{
+    int fd = open(task->path.constData(), O_RDONLY|O_DIRECTORY|O_NOFOLLOW|O_CLOEXEC);
+    DIR *dir = fd < 0? nullptr: fdopendir(fd);
+    if (!dir) {
+        reportError(task->path, errno);
+        if (fd >= 0)
+            close(fd);
+        task->failed.store(1);
+        finishTask(task);
+        return;
+    }
+
+    struct dirent *entry = nullptr;
+    while ((entry = readdir(dir))) {
+        if (isCancelled()) {
+            task->failed.store(1);
+            break;
+        }
+
+        const char *name = entry->d_name;
+        if (qstrcmp(name, ".") == 0 || qstrcmp(name, "..") == 0)
+            continue;
+
+        bool isDir = entry->d_type == DT_DIR;
+        if (entry->d_type == DT_UNKNOWN) {
+            struct stat st;
+            isDir = fstatat(fd, name, &st, AT_SYMLINK_NOFOLLOW) == 0 && S_ISDIR(st.st_mode);
+        }
+
+        addFound();
+        QByteArray childPath = task->path + '/' + name;
+        if (isDir) {
+            auto child = new FileDeleteTask;
+            child->path = childPath;
+            child->parent = task;
+            task->pending.ref();
+            m_pool->start(new FileDeleteJob(this, child));
+        } else if (unlinkat(fd, name, 0) == 0) {
+            addDeleted(childPath);
+        } else {
+            reportError(childPath, errno);
+            task->failed.store(1);
+        }
+    }
+    closedir(dir);
+
+    finishTask(task);
+}
+
+void FileDeleteEngine::finishTask(FileDeleteTask *task)
+{
+    //remove the directories whose children have all been handled, up to root.
+    while (task && !task->pending.deref()) {
+        FileDeleteTask *parent = task->parent;
+        if (task->failed.load() == 0 && !isCancelled()) {
+            if (rmdir(task->path.constData()) == 0) {
+                addDeleted(task->path);
+            } else {
+                reportError(task->path, errno);
+                task->failed.store(1);
+            }
+        }
+        //a directory with undeleted children can not be removed.
+        if (parent && task->failed.load() != 0)
+            parent->failed.store(1);
+        delete task;
+        task = parent;
+    }
+}
+
+void FileDeleteEngine::addFound(int count)
+{
+    //the files are found ahead of deleting, report them in batches too,
+    //so that the total count is known before they are deleted.
+    m_progress_mutex.lock();
+    m_found_count += count;
+    bool shouldFlush = m_found_count >= PROGRESS_BATCH_SIZE;
+    m_progress_mutex.unlock();
+
+    if (shouldFlush)
+        flushProgress();
+}
+
+void FileDeleteEngine::addDeleted(const QByteArray &path)
+{
+    m_progress_mutex.lock();
+    m_deleted_count++;
+    m_last_deleted_path = path;
+    bool shouldFlush = m_deleted_count >= PROGRESS_BATCH_SIZE;
+    m_progress_mutex.unlock();
+
+    if (shouldFlush)
+        flushProgress();
+}
+
+void FileDeleteEngine::flushProgress()
+{
+    QMutexLocker locker(&m_progress_mutex);
+    if (m_found_count == 0 && m_deleted_count == 0)
+        return;
+
+    if (m_progress_handler) {
+        char *uri = g_filename_to_uri(m_last_deleted_path.constData(), nullptr, nullptr);
+        m_progress_handler(uri, m_found_count, m_deleted_count);
+        g_free(uri);
+    }
+    m_found_count = 0;
+    m_deleted_count = 0;
+}
+
+void FileDeleteEngine::reportError(const QByteArray &path, int errnum)
+{
+    m_failed.store(1);
+    if (!m_error_handler)
+        return;
+
+    char *uri = g_filename_to_uri(path.constData(), nullptr, nullptr);
+    char *display_name = g_filename_display_name(path.constData());
+    GError *err = g_error_new(G_IO_ERROR,
+                              g_io_error_from_errno(errnum),
+                              "Error removing file %s: %s",
+                              display_name,
+                              g_strerror(errnum));
+    g_free(display_name);
+
+    m_error_mutex.lock();
+    m_error_handler(uri, GErrorWrapper::wrapFrom(err));
+    m_error_mutex.unlock();
+    g_free(uri);
+}
+
+bool FileDeleteEngine::isCancelled()
+{
+    return m_cancellable && g_cancellable_is_cancelled(m_cancellable);
+}
@@ -0,0 +1,98 @@
+#ifndef FILEDELETEENGINE_H
+#define FILEDELETEENGINE_H
+
+#include "peony-core_global.h"
+#include "gerror-wrapper.h"
+
+#include <QMutex>
+#include <QAtomicInt>
+#include <functional>
+#include <gio/gio.h>
+
+class QThreadPool;
+
+namespace Peony {
+
+class FileDeleteJob;
+struct FileDeleteTask;
+
+/*!
+ * \brief The FileDeleteEngine class
+ * <br>
+ * FileDeleteEngine deletes local files and directory trees without building
+ * a FileNode tree and without gio. Each directory is opened once, its entries
+ * are removed with unlinkat() relative to the directory fd as soon as they are
+ * read, and its sub directories are handled by other jobs of a thread pool.
+ * A directory is removed when its last sub directory has been removed.
+ * </br>
+ * <br>
+ * The errors are reported item by item with the error handler, and the progress
+ * is reported in batches with the progress handler. The handlers are called in
+ * the engine's threads, and the calls are serialized.
+ * </br>
+ * \note
+ * The engine only supports native files, use isSupported() for checking. The
+ * symbolic links are deleted rather than followed.
+ * \see FileDeleteOperation, FileMoveOperation.
+ */
+class PEONYCORESHARED_EXPORT FileDeleteEngine
+{
+    friend class FileDeleteJob;
+public:
+    typedef std::function<void(const QString &uri, const GErrorWrapperPtr &err)> ErrorHandler;
+    /*!
+     * \brief ProgressHandler
+     * \details
+     * uri is the last deleted file, foundCount and deletedCount are the counts of
+     * files found and deleted since the last report.
+     */
+    typedef std::function<void(const QString &uri, int foundCount, int deletedCount)> ProgressHandler;
+
+    explicit FileDeleteEngine(GCancellable *cancellable = nullptr);
+    ~FileDeleteEngine();
+
+    void setErrorHandler(ErrorHandler handler) {m_error_handler = handler;}
+    void setProgressHandler(ProgressHandler handler) {m_progress_handler = handler;}
+
+    static bool isSupported(const QString &uri);
+
+    /*!
+     * \brief deleteUri
+     * \param uri, a native file or directory.
+     * \return true if the file and all its children have been deleted.
+     * <br>
+     * This blocks until the whole tree has been handled or cancelled.
+     * </br>
+     */
+    bool deleteUri(const QString &uri);
+
+protected:
+    void scanDirectory(FileDeleteTask *task);
+    void finishTask(FileDeleteTask *task);
+
+    void addFound(int count = 1);
+    void addDeleted(const QByteArray &path);
+    void flushProgress();
+    void reportError(const QByteArray &path, int errnum);
+
+    bool isCancelled();
+
+private:
+    GCancellable *m_cancellable = nullptr;
+    QThreadPool *m_pool = nullptr;
+
+    ErrorHandler m_error_handler = nullptr;
+    ProgressHandler m_progress_handler = nullptr;
+
+    QAtomicInt m_failed = 0;
+
+    QMutex m_error_mutex;
+    QMutex m_progress_mutex;
+    int m_found_count = 0;
+    int m_deleted_count = 0;
+    QByteArray m_last_deleted_path;
+};
+
+}
+
+#endif // FILEDELETEENGINE_H
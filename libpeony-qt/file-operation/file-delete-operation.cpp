@@ -2,6 +2,11 @@
 #include "file-operation-manager.h"
 #include "file-node.h"
 #include "file-node-reporter.h"
+#include "file-node-scanner.h"
+#include "file-delete-engine.h"
+#include "file-operation-progress.h"
+
+#include <QSet>
 
 using namespace Peony;
 
@@ -9,7 +14,8 @@ FileDeleteOperation::FileDeleteOperation(QStringList sourceUris, QObject *parent
 {
     m_source_uris = sourceUris;
     m_reporter = new FileNodeReporter;
-    connect(m_reporter, &FileNodeReporter::nodeFound, this, &FileOperation::operationPreparedOne);
+    //the nodes are found in operation thread, do not queue the signal to ui thread.
+    connect(m_reporter, &FileNodeReporter::nodeFound, this, &FileOperation::operationPreparedOne, Qt::DirectConnection);
 }
 
 FileDeleteOperation::~FileDeleteOperation()
@@ -22,19 +28,31 @@ void FileDeleteOperation::deleteRecursively(FileNode *node)
     if (isCancelled())
         return;
 
-    GFile *file = g_file_new_for_uri(node->uri().toUtf8().constData());
     if (node->isFolder()) {
         for (auto child : *(node->children())) {
             deleteRecursively(child);
         }
+    }
+    deleteNode(node);
+}
+
+void FileDeleteOperation::deleteNode(FileNode *node)
+{
+    if (isCancelled())
+        return;
+    //the enumerate error is reported instead, it is not empty.
+    if (node->isIncomplete())
+        return;
+
+    GFile *file = g_file_new_for_uri(node->uri().toUtf8().constData());
+    if (node->isFolder()) {
         GError *err = nullptr;
         g_file_delete(file,
                       getCancellable().get()->get(),
                       &err);
         if (err) {
             //if delete a file get into error, it might be a critical error.
-            auto response = errored(node->uri(), nullptr, GErrorWrapper::wrapFrom(err), true);
-            qDebug()<<response;
+            errored(node->uri(), nullptr, GErrorWrapper::wrapFrom(err), true);
         }
     } else {
         GError *err = nullptr;
@@ -43,12 +61,10 @@ void FileDeleteOperation::deleteRecursively(FileNode *node)
                       &err);
         if (err) {
             //if delete a file get into error, it might be a critical error.
-            auto response = errored(node->uri(), nullptr, GErrorWrapper::wrapFrom(err), true);
-            qDebug()<<response;
+            errored(node->uri(), nullptr, GErrorWrapper::wrapFrom(err), true);
         }
     }
     g_object_unref(file);
-    qDebug()<<"deleted";
     operationAfterProgressedOne(node->uri());
 }
 
@@ -61,26 +77,110 @@ void FileDeleteOperation::run()
 
     Q_EMIT operationRequestShowWizard();
 
+    //the local files are deleted by FileDeleteEngine, without building the trees.
+    QStringList uris;
+    QSet<QString> localUris;
+    for (auto uri : m_source_uris) {
+        if (FileDeleteEngine::isSupported(uri))
+            localUris<<uri;
+        else
+            uris<<uri;
+    }
+    //the stages are sent once, even if there are both local and remote files.
+    bool prepared = false;
+    if (!localUris.isEmpty()) {
+        operationPrepared();
+        //jump to the clearing stage.
+        operationProgressed();
+        prepared = true;
+
+        FileDeleteEngine engine(getCancellable().get()->get());
+        engine.setErrorHandler([=](const QString &uri, const GErrorWrapperPtr &err) {
+            //if delete a file get into error, it might be a critical error.
+            errored(uri, nullptr, err, true);
+        });
+        engine.setProgressHandler([=](const QString &uri, int foundCount, int deletedCount) {
+            progress()->addFound(uri, 0, foundCount);
+            progress()->addCleared(uri, deletedCount);
+        });
+        for (auto uri : m_source_uris) {
+            if (isCancelled())
+                break;
+            if (localUris.contains(uri))
+                engine.deleteUri(uri);
+        }
+    }
+
     goffset *total_size = new goffset(0);
 
     QList<FileNode*> nodes;
-    for (auto uri : m_source_uris) {
-        FileNode *node = new FileNode(uri, nullptr, m_reporter);
-        node->findChildrenRecursively();
-        node->computeTotalSize(total_size);
-        nodes<<node;
+    if (uris.isEmpty()) {
+        //nothing left, all the files are local.
+    } else if (isPipelined()) {
+        FileNodeScanner scanner(m_reporter, true);
+        for (auto uri : uris) {
+            FileNode *node = new FileNode(uri, nullptr, m_reporter);
+            scanner.start(node);
+            nodes<<node;
+        }
+        if (!prepared) {
+            operationPrepared();
+            //jump to the clearing stage.
+            operationProgressed();
+        }
+
+        //delete the files as soon as they are found. a folder is found
+        //before its children, so the folders are deleted in reverse order
+        //after the scan finished.
+        QList<FileNode*> folders;
+        while (FileNode *node = scanner.takeNode()) {
+            if (isCancelled()) {
+                scanner.cancel();
+                break;
+            }
+            if (node->isFolder()) {
+                folders<<node;
+            } else {
+                deleteNode(node);
+            }
+        }
+        scanner.waitForFinished();
+        for (int i = folders.count() - 1; i >= 0; i--) {
+            deleteNode(folders.at(i));
+        }
+        for (auto node : nodes) {
+            node->computeTotalSize(total_size);
+        }
+    } else {
+        for (auto uri : uris) {
+            FileNode *node = new FileNode(uri, nullptr, m_reporter);
+            node->findChildrenRecursively();
+            node->computeTotalSize(total_size);
+            nodes<<node;
+        }
+        if (!prepared) {
+            operationPrepared();
+            //jump to the clearing stage.
+            operationProgressed();
+        }
+
+        for (auto node : nodes) {
+            deleteRecursively(node);
+        }
     }
-    operationPrepared();
 
     m_total_szie = *total_size;
     delete total_size;
 
-    //jump to the clearing stage.
-    operationProgressed();
+    //the folders which could not be enumerated are not deleted.
+    for (auto error : m_reporter->takeEnumerateErrors()) {
+        errored(error.first, nullptr, error.second, true);
+    }
 
     for (auto node : nodes) {
-        deleteRecursively(node);
+        delete node;
     }
+    nodes.clear();
 
     Q_EMIT operationFinished();
 }
@@ -18,7 +18,16 @@ public:
     ~FileDeleteOperation() override;
 
     void deleteRecursively(FileNode *node);
+    /*!
+     * \brief deleteNode
+     * \param node
+     * <br>
+     * Delete a file or an empty folder, the children of folder must have been deleted.
+     * </br>
+     */
+    void deleteNode(FileNode *node);
     void run() override;
+    QStringList involvedUris() override {return m_source_uris;}
 
 private:
     QStringList m_source_uris;
@@ -1,11 +1,27 @@
 #include "file-move-operation.h"
 #include "file-node-reporter.h"
 #include "file-node.h"
+#include "file-node-scanner.h"
+#include "file-copy-engine.h"
+#include "file-delete-engine.h"
+#include "file-operation-progress.h"
 #include "file-enumerator.h"
 #include "file-info.h"
 
 #include "file-operation-manager.h"
 
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <errno.h>
+
+#ifndef RENAME_NOREPLACE
+#define RENAME_NOREPLACE (1 << 0)
+#endif
+
 using namespace Peony;
 
 FileMoveOperation::FileMoveOperation(QStringList sourceUris, QString destDirUri, QObject *parent) : FileOperation (parent)
@@ -13,6 +29,7 @@ FileMoveOperation::FileMoveOperation(QStringList sourceUris, QString destDirUri,
     m_source_uris = sourceUris;
     m_dest_dir_uri = destDirUri;
     m_info = std::make_shared<FileOperationInfo>(sourceUris, destDirUri, FileOperationInfo::Move);
+    m_dest_dir_file.reset(g_file_new_for_uri(destDirUri.toUtf8().constData()));
 }
 
 FileMoveOperation::~FileMoveOperation()
@@ -25,10 +42,10 @@ void FileMoveOperation::progress_callback(goffset current_num_bytes,
                                           goffset total_num_bytes,
                                           FileMoveOperation *p_this)
 {
-    Q_EMIT p_this->FileProgressCallback(p_this->m_current_src_uri,
-                                        p_this->m_current_dest_dir_uri,
-                                        current_num_bytes,
-                                        total_num_bytes);
+    p_this->reportFileProgress(p_this->m_current_src_uri,
+                               p_this->m_current_dest_dir_uri,
+                               current_num_bytes,
+                               total_num_bytes);
     //format: move srcUri to destDirUri: curent_bytes(count) of total_bytes(count).
 }
 
@@ -40,13 +57,88 @@ FileOperation::ResponseType FileMoveOperation::prehandle(GError *err)
     return Other;
 }
 
+static int renameNoReplace(int old_dir_fd, const char *old_path, int new_dir_fd, const char *new_path)
+{
+#ifdef SYS_renameat2
+    int ret = int(syscall(SYS_renameat2, old_dir_fd, old_path, new_dir_fd, new_path, RENAME_NOREPLACE));
+    if (ret == 0 || (errno != ENOSYS && errno != EINVAL))
+        return ret;
+#endif
+    //the kernel or file system does not support renameat2(), check the dest
+    //before renaming. It is racy, so leave the existed one to gio.
+    struct stat st;
+    if (fstatat(new_dir_fd, new_path, &st, AT_SYMLINK_NOFOLLOW) == 0) {
+        errno = EEXIST;
+        return -1;
+    }
+    return renameat(old_dir_fd, old_path, new_dir_fd, new_path);
+}
+
+QStringList FileMoveOperation::renameNatively()
+{
+    char *dest_dir_path = g_filename_from_uri(m_dest_dir_uri.toUtf8().constData(), nullptr, nullptr);
+    if (!dest_dir_path)
+        return m_source_uris;
+
+    int dest_dir_fd = open(dest_dir_path, O_RDONLY|O_DIRECTORY|O_CLOEXEC);
+    struct stat dest_dir_stat;
+    if (dest_dir_fd < 0 || fstat(dest_dir_fd, &dest_dir_stat) != 0) {
+        if (dest_dir_fd >= 0)
+            close(dest_dir_fd);
+        g_free(dest_dir_path);
+        return m_source_uris;
+    }
+
+    QStringList uris;
+    int renamedCount = 0;
+    for (int i = 0; i < m_source_uris.count(); i++) {
+        if (isCancelled()) {
+            uris<<m_source_uris.mid(i);
+            break;
+        }
+
+        auto srcUri = m_source_uris.at(i);
+        char *src_path = g_filename_from_uri(srcUri.toUtf8().constData(), nullptr, nullptr);
+        struct stat src_stat;
+        if (!src_path || lstat(src_path, &src_stat) != 0 || src_stat.st_dev != dest_dir_stat.st_dev) {
+            g_free(src_path);
+            uris<<srcUri;
+            continue;
+        }
+
+        char *base_name = g_path_get_basename(src_path);
+        if (renameNoReplace(AT_FDCWD, src_path, dest_dir_fd, base_name) == 0) {
+            char *dest_path = g_build_filename(dest_dir_path, base_name, nullptr);
+            m_renamed_paths<<qMakePair(QByteArray(src_path), QByteArray(dest_path));
+            g_free(dest_path);
+            renamedCount++;
+        } else {
+            //let gio handle the error, such as a existed target.
+            uris<<srcUri;
+        }
+        g_free(base_name);
+        g_free(src_path);
+    }
+
+    close(dest_dir_fd);
+    g_free(dest_dir_path);
+
+    //the renamed files are reported in batch.
+    progress()->addFound(nullptr, 0, renamedCount);
+    progress()->addProgressed(nullptr, m_dest_dir_uri, 0, renamedCount);
+    return uris;
+}
+
 void FileMoveOperation::move()
 {
     if (isCancelled())
         return;
 
+    //the sources on the same device are renamed without nodes.
+    QStringList uris = renameNatively();
+
     QList<FileNode*> nodes;
-    for (auto srcUri : m_source_uris) {
+    for (auto srcUri : uris) {
         //FIXME: ignore the total size when using native move.
         operationPreparedOne(srcUri, 0);
         auto node = new FileNode(srcUri, nullptr, nullptr);
@@ -54,23 +146,22 @@ void FileMoveOperation::move()
     }
     operationPrepared();
 
-    auto destDir = wrapGFile(g_file_new_for_uri(m_dest_dir_uri.toUtf8().constData()));
     m_total_count = m_source_uris.count();
+    QStringList fallbackUris;
     for (auto file : nodes) {
         if (isCancelled())
-            return;
+            break;
 
         QString srcUri = file->uri();
-        m_current_count = nodes.indexOf(file) + 1;
+        m_current_count = m_renamed_paths.count() + nodes.indexOf(file) + 1;
         m_current_src_uri = srcUri;
         m_current_dest_dir_uri = m_dest_dir_uri;
 
-        auto srcFile = wrapGFile(g_file_new_for_uri(srcUri.toUtf8().constData()));
-        char *base_name = g_file_get_basename(srcFile.get()->get());
-        auto destFile = wrapGFile(g_file_resolve_relative_path(destDir.get()->get(),
-                                                               base_name));
+        GFileHandle srcFile(g_file_new_for_uri(srcUri.toUtf8().constData()));
+        char *base_name = g_file_get_basename(srcFile.get());
+        GFileHandle destFile(g_file_resolve_relative_path(m_dest_dir_file.get(), base_name));
 
-        char *dest_uri = g_file_get_uri(destFile.get()->get());
+        char *dest_uri = g_file_get_uri(destFile.get());
         file->setDestUri(dest_uri);
 
         g_free(dest_uri);
@@ -78,8 +169,8 @@ void FileMoveOperation::move()
 
 retry:
         GError *err = nullptr;
-        g_file_move(srcFile.get()->get(),
-                    destFile.get()->get(),
+        g_file_move(srcFile.get(),
+                    destFile.get(),
                     m_default_copy_flag,
                     getCancellable().get()->get(),
                     GFileProgressCallback(progress_callback),
@@ -89,16 +180,20 @@ retry:
         if (err) {
             auto errWrapper = GErrorWrapper::wrapFrom(err);
             switch (errWrapper.get()->code()) {
-            case G_IO_ERROR_CANCELLED:
-                return;
+            case G_IO_ERROR_CANCELLED: {
+                //this source was not moved, leave the loop for rollbacking the others.
+                file->setState(FileNode::Unhandled);
+                file->setErrorResponse(FileOperation::IgnoreOne);
+                cancel();
+                continue;
+            }
             case G_IO_ERROR_NOT_SUPPORTED:
             case G_IO_ERROR_WOULD_RECURSE: {
-                m_force_use_fallback = true;
-                for (auto node : nodes) {
-                    delete node;
-                }
-                nodes.clear();
-                return;
+                //only this source need copy and delete, it is not rollbacked here.
+                file->setState(FileNode::Unhandled);
+                file->setErrorResponse(FileOperation::IgnoreOne);
+                fallbackUris<<srcUri;
+                continue;
             }
             default:
                 break;
@@ -127,8 +222,8 @@ retry:
             case OverWriteOne: {
                 file->setState(FileNode::Handled);
                 file->setErrorResponse(FileOperation::OverWriteOne);
-                g_file_move(srcFile.get()->get(),
-                            destFile.get()->get(),
+                g_file_move(srcFile.get(),
+                            destFile.get(),
                             GFileCopyFlags(m_default_copy_flag|G_FILE_COPY_OVERWRITE),
                             getCancellable().get()->get(),
                             GFileProgressCallback(progress_callback),
@@ -139,8 +234,8 @@ retry:
             case OverWriteAll: {
                 file->setState(FileNode::Handled);
                 file->setErrorResponse(FileOperation::OverWriteOne);
-                g_file_move(srcFile.get()->get(),
-                            destFile.get()->get(),
+                g_file_move(srcFile.get(),
+                            destFile.get(),
                             GFileCopyFlags(m_default_copy_flag|G_FILE_COPY_OVERWRITE),
                             getCancellable().get()->get(),
                             GFileProgressCallback(progress_callback),
@@ -152,8 +247,8 @@ retry:
             case BackupOne: {
                 file->setState(FileNode::Handled);
                 file->setErrorResponse(FileOperation::BackupOne);
-                g_file_move(srcFile.get()->get(),
-                            destFile.get()->get(),
+                g_file_move(srcFile.get(),
+                            destFile.get(),
                             GFileCopyFlags(m_default_copy_flag|G_FILE_COPY_BACKUP),
                             getCancellable().get()->get(),
                             GFileProgressCallback(progress_callback),
@@ -164,8 +259,8 @@ retry:
             case BackupAll: {
                 file->setState(FileNode::Handled);
                 file->setErrorResponse(FileOperation::BackupOne);
-                g_file_move(srcFile.get()->get(),
-                            destFile.get()->get(),
+                g_file_move(srcFile.get(),
+                            destFile.get(),
                             GFileCopyFlags(m_default_copy_flag|G_FILE_COPY_BACKUP),
                             getCancellable().get()->get(),
                             GFileProgressCallback(progress_callback),
@@ -190,6 +285,11 @@ retry:
         //FIXME: ignore the total size when using native move.
         operationProgressedOne(file->uri(), file->destUri(), 0);
     }
+    //the sources which can not be moved natively are copied and deleted,
+    //the others have been moved.
+    if (!fallbackUris.isEmpty() && !isCancelled())
+        moveForceUseFallback(fallbackUris);
+
     //native move has not clear operation.
     operationProgressed();
 
@@ -198,6 +298,11 @@ retry:
     //such as the target is existed, the rollback might
     //get into error too.
     if (isCancelled()) {
+        for (auto paths : m_renamed_paths) {
+            rename(paths.second.constData(), paths.first.constData());
+        }
+        m_renamed_paths.clear();
+
         for (auto file : nodes) {
             if (!file->destUri().isEmpty()) {
                 GFileWrapperPtr destFile = wrapGFile(g_file_new_for_uri(file->destUri().toUtf8().constData()));
@@ -372,32 +477,48 @@ void FileMoveOperation::copyRecursively(FileNode *node)
     if (isCancelled())
         return;
 
-    QString relativePath = node->getRelativePath();
-    //FIXME: the smart pointers' deconstruction spends too much time.
-    GFileWrapperPtr destRoot = wrapGFile(g_file_new_for_uri(m_dest_dir_uri.toUtf8().constData()));
-    GFileWrapperPtr destFile = wrapGFile(g_file_resolve_relative_path(destRoot.get()->get(),
-                                                                      relativePath.toUtf8().constData()));
+    copyNode(node);
+    for (auto child : *(node->children())) {
+        copyRecursively(child);
+    }
+}
+
+void FileMoveOperation::copyNode(FileNode *node)
+{
+    if (isCancelled())
+        return;
 
-    char *dest_file_uri = g_file_get_uri(destFile.get()->get());
-    node->setDestUri(dest_file_uri);
-    g_free(dest_file_uri);
+    GFileHandle destFile;
     m_current_src_uri = node->uri();
-    GFile *dest_parent = g_file_get_parent(destFile.get()->get());
-    char *dest_dir_uri = g_file_get_uri(dest_parent);
-    m_current_dest_dir_uri = dest_dir_uri;
-    g_free(dest_dir_uri);
-    g_object_unref(dest_parent);
+    if (node->parent()) {
+        //the dest uri of a child is built from its parent's.
+        destFile.reset(g_file_new_for_uri(node->destUri().toUtf8().constData()));
+        m_current_dest_dir_uri = node->parent()->destUri();
+    } else {
+        QString relativePath = node->getRelativePath();
+        destFile.reset(g_file_resolve_relative_path(m_dest_dir_file.get(),
+                                                    relativePath.toUtf8().constData()));
+
+        char *dest_file_uri = g_file_get_uri(destFile.get());
+        node->setDestUri(dest_file_uri);
+        g_free(dest_file_uri);
+        GFileHandle destParent(g_file_get_parent(destFile.get()));
+        char *dest_dir_uri = g_file_get_uri(destParent.get());
+        m_current_dest_dir_uri = dest_dir_uri;
+        g_free(dest_dir_uri);
+    }
+    auto copy = isJournaled()? FileCopyEngine::copyResumable: FileCopyEngine::copy;
 
 fallback_retry:
     if (node->isFolder()) {
         GError *err = nullptr;
 
         //NOTE: mkdir doesn't have a progress callback.
-        Q_EMIT FileProgressCallback(m_current_src_uri,
-                                    m_current_dest_dir_uri,
-                                    node->size(),
-                                    node->size());
-        g_file_make_directory(destFile.get()->get(),
+        reportFileProgress(m_current_src_uri,
+                           m_current_dest_dir_uri,
+                           node->size(),
+                           node->size());
+        g_file_make_directory(destFile.get(),
                               getCancellable().get()->get(),
                               &err);
         if (err) {
@@ -464,24 +585,22 @@ fallback_retry:
             node->setState(FileNode::Handled);
         }
         //assume that make dir finished anyway
-        Q_EMIT FileProgressCallback(m_current_src_uri,
-                                    m_current_dest_dir_uri,
-                                    node->size(),
-                                    node->size());
+        reportFileProgress(m_current_src_uri,
+                           m_current_dest_dir_uri,
+                           node->size(),
+                           node->size());
         Q_EMIT operationProgressedOne(node->uri(), node->destUri(), node->size());
-        for (auto child : *(node->children())) {
-            copyRecursively(child);
-        }
     } else {
         GError *err = nullptr;
-        GFileWrapperPtr sourceFile = wrapGFile(g_file_new_for_uri(node->uri().toUtf8().constData()));
-        g_file_copy(sourceFile.get()->get(),
-                    destFile.get()->get(),
-                    m_default_copy_flag,
-                    getCancellable().get()->get(),
-                    GFileProgressCallback(progress_callback),
-                    this,
-                    &err);
+        GFileHandle sourceFile(g_file_new_for_uri(node->uri().toUtf8().constData()));
+        copy(sourceFile.get(),
+             destFile.get(),
+             m_default_copy_flag,
+             getCancellable().get()->get(),
+             GFileProgressCallback(progress_callback),
+             this,
+             &err,
+             nullptr);
 
         if (err) {
             if (err->code == G_IO_ERROR_CANCELLED) {
@@ -509,50 +628,54 @@ fallback_retry:
                 break;
             }
             case OverWriteOne: {
-                g_file_copy(sourceFile.get()->get(),
-                            destFile.get()->get(),
-                            GFileCopyFlags(m_default_copy_flag | G_FILE_COPY_OVERWRITE),
-                            getCancellable().get()->get(),
-                            GFileProgressCallback(progress_callback),
-                            this,
-                            nullptr);
+                copy(sourceFile.get(),
+                     destFile.get(),
+                     GFileCopyFlags(m_default_copy_flag | G_FILE_COPY_OVERWRITE),
+                     getCancellable().get()->get(),
+                     GFileProgressCallback(progress_callback),
+                     this,
+                     nullptr,
+                     nullptr);
                 node->setState(FileNode::Handled);
                 node->setErrorResponse(OverWriteOne);
                 break;
             }
             case OverWriteAll: {
-                g_file_copy(sourceFile.get()->get(),
-                            destFile.get()->get(),
-                            GFileCopyFlags(m_default_copy_flag | G_FILE_COPY_OVERWRITE),
-                            getCancellable().get()->get(),
-                            GFileProgressCallback(progress_callback),
-                            this,
-                            nullptr);
+                copy(sourceFile.get(),
+                     destFile.get(),
+                     GFileCopyFlags(m_default_copy_flag | G_FILE_COPY_OVERWRITE),
+                     getCancellable().get()->get(),
+                     GFileProgressCallback(progress_callback),
+                     this,
+                     nullptr,
+                     nullptr);
                 node->setState(FileNode::Handled);
                 node->setErrorResponse(OverWriteOne);
                 m_prehandle_hash.insert(err->code, OverWriteOne);
                 break;
             }
             case BackupOne: {
-                g_file_copy(sourceFile.get()->get(),
-                            destFile.get()->get(),
-                            GFileCopyFlags(m_default_copy_flag | G_FILE_COPY_BACKUP),
-                            getCancellable().get()->get(),
-                            GFileProgressCallback(progress_callback),
-                            this,
-                            nullptr);
+                copy(sourceFile.get(),
+                     destFile.get(),
+                     GFileCopyFlags(m_default_copy_flag | G_FILE_COPY_BACKUP),
+                     getCancellable().get()->get(),
+                     GFileProgressCallback(progress_callback),
+                     this,
+                     nullptr,
+                     nullptr);
                 node->setState(FileNode::Handled);
                 node->setErrorResponse(BackupOne);
                 break;
             }
             case BackupAll: {
-                g_file_copy(sourceFile.get()->get(),
-                            destFile.get()->get(),
-                            GFileCopyFlags(m_default_copy_flag | G_FILE_COPY_BACKUP),
-                            getCancellable().get()->get(),
-                            GFileProgressCallback(progress_callback),
-                            this,
-                            nullptr);
+                copy(sourceFile.get(),
+                     destFile.get(),
+                     GFileCopyFlags(m_default_copy_flag | G_FILE_COPY_BACKUP),
+                     getCancellable().get()->get(),
+                     GFileProgressCallback(progress_callback),
+                     this,
+                     nullptr,
+                     nullptr);
                 node->setState(FileNode::Handled);
                 node->setErrorResponse(BackupOne);
                 m_prehandle_hash.insert(err->code, BackupOne);
@@ -573,8 +696,31 @@ fallback_retry:
         }
         Q_EMIT operationProgressedOne(node->uri(), node->destUri(), node->size());
     }
-    destFile.reset();
-    destRoot.reset();
+}
+
+/*!
+ * \brief isTreeCopied
+ * \return true if all nodes of the tree have been copied without any error.
+ */
+static bool isTreeCopied(FileNode *node)
+{
+    if (node->state() != FileNode::Handled || node->responseType() != FileOperation::Other)
+        return false;
+    if (node->isIncomplete())
+        return false;
+    for (auto child : *node->children()) {
+        if (!isTreeCopied(child))
+            return false;
+    }
+    return true;
+}
+
+static void setTreeCleared(FileNode *node)
+{
+    node->setState(FileNode::Cleared);
+    for (auto child : *node->children()) {
+        setTreeCleared(child);
+    }
 }
 
 void FileMoveOperation::deleteRecursively(FileNode *node)
@@ -582,6 +728,24 @@ void FileMoveOperation::deleteRecursively(FileNode *node)
     if (isCancelled())
         return;
 
+    //a local tree which has been copied completely is deleted by the engine at once.
+    if (!node->parent() && FileDeleteEngine::isSupported(node->uri()) && isTreeCopied(node)) {
+        FileDeleteEngine engine(getCancellable().get()->get());
+        engine.setErrorHandler([=](const QString &uri, const GErrorWrapperPtr &err) {
+            //the source could not be removed, it might be a critical error.
+            errored(uri, nullptr, err, true);
+        });
+        engine.setProgressHandler([=](const QString &uri, int foundCount, int deletedCount) {
+            Q_UNUSED(foundCount);
+            progress()->addCleared(uri, deletedCount);
+        });
+        //the copied files are moved back when rollbacking, the remained source files
+        //will not be overwritten. a tree partly deleted is not cleared, its copy is kept.
+        if (engine.deleteUri(node->uri()))
+            setTreeCleared(node);
+        return;
+    }
+
     GFile *file = g_file_new_for_uri(node->uri().toUtf8().constData());
     if (node->isFolder()) {
         for (auto child : *(node->children())) {
@@ -598,36 +762,70 @@ void FileMoveOperation::deleteRecursively(FileNode *node)
         node->setState(FileNode::Cleared);
     }
     g_object_unref(file);
-    qDebug()<<"deleted";
     operationAfterProgressedOne(node->uri());
 }
 
-void FileMoveOperation::moveForceUseFallback()
+void FileMoveOperation::moveForceUseFallback(const QStringList &uris)
 {
     if (isCancelled())
         return;
 
     Q_EMIT operationRequestShowWizard();
     m_reporter = new FileNodeReporter;
-    connect(m_reporter, &FileNodeReporter::nodeFound, this, &FileMoveOperation::operationPreparedOne);
+    //the nodes are found in operation thread, do not queue the signal to ui thread.
+    connect(m_reporter, &FileNodeReporter::nodeFound, this, &FileMoveOperation::operationPreparedOne, Qt::DirectConnection);
 
     //FIXME: total size should not compute twice. I should get it from ui-thread.
     goffset *total_size = new goffset(0);
 
     QList<FileNode*> nodes;
-    for (auto uri : m_source_uris) {
-        FileNode *node = new FileNode(uri, nullptr, m_reporter);
-        node->findChildrenRecursively();
-        node->computeTotalSize(total_size);
-        nodes<<node;
+    if (isPipelinedInto(uris, m_dest_dir_uri)) {
+        //copy the nodes as soon as they are found, the sources are
+        //deleted after the whole trees copied.
+        FileNodeScanner scanner(m_reporter, true);
+        for (auto uri : uris) {
+            FileNode *node = new FileNode(uri, nullptr, m_reporter);
+            scanner.start(node);
+            nodes<<node;
+        }
+        operationPrepared();
+
+        while (FileNode *node = scanner.takeNode()) {
+            if (isCancelled()) {
+                scanner.cancel();
+                break;
+            }
+            copyNode(node);
+        }
+        scanner.waitForFinished();
+        for (auto node : nodes) {
+            node->computeTotalSize(total_size);
+        }
+    } else {
+        for (auto uri : uris) {
+            FileNode *node = new FileNode(uri, nullptr, m_reporter);
+            node->findChildrenRecursively();
+            node->computeTotalSize(total_size);
+            nodes<<node;
+        }
+        operationPrepared();
+
+        for (auto node : nodes) {
+            copyRecursively(node);
+        }
     }
-    operationPrepared();
 
     m_total_szie = *total_size;
     delete total_size;
 
-    for (auto node : nodes) {
-        copyRecursively(node);
+    //the folders which could not be enumerated are not copied completely,
+    //their sources are kept.
+    for (auto error : m_reporter->takeEnumerateErrors()) {
+        if (isCancelled())
+            break;
+        auto responseData = errored(error.first, m_dest_dir_uri, error.second, true);
+        if (responseData.value<ResponseType>() == Cancel)
+            cancel();
     }
     operationProgressed();
 
@@ -712,7 +910,7 @@ start:
 
     //ensure again
     if (m_force_use_fallback) {
-        moveForceUseFallback();
+        moveForceUseFallback(m_source_uris);
     }
     qDebug()<<"finished";
 end:
@@ -75,11 +75,37 @@ protected:
                                   FileMoveOperation *p_this);
 
     void copyRecursively(FileNode *node);
+    /*!
+     * \brief copyNode
+     * \param node
+     * <br>
+     * Create a folder or copy a file, the parent node must have been handled.
+     * </br>
+     */
+    void copyNode(FileNode *node);
     void deleteRecursively(FileNode *node);
 
     bool isInvalid();
+    /*!
+     * \brief renameNatively
+     * \return the uris which are not renamed.
+     * <br>
+     * Rename the local sources which are on the same device as dest directory
+     * with renameat2() in batch, it does not create nodes nor send signals of
+     * each file. The sources left should be moved by gio.
+     * </br>
+     */
+    QStringList renameNatively();
     void move();
-    void moveForceUseFallback();
+    /*!
+     * \brief moveForceUseFallback
+     * \param uris, the sources to be copied and deleted.
+     * <br>
+     * It is used for all the sources if fallback is forced, otherwise move()
+     * only passes the sources which can not be moved natively.
+     * </br>
+     */
+    void moveForceUseFallback(const QStringList &uris);
 
     /*!
      * \brief prehandle
@@ -100,6 +126,12 @@ protected:
 private:
     QStringList m_source_uris;
     QString m_dest_dir_uri = nullptr;
+    /*!
+     * \brief m_dest_dir_file
+     * \details
+     * The dest dir, it is used for resolving the dest files of sources and roots.
+     */
+    GFileHandle m_dest_dir_file;
 
     /*!
      * \brief m_current_count, used in progress_callback
@@ -143,6 +175,14 @@ private:
      */
     QHash<int, ResponseType> m_prehandle_hash;
 
+    /*!
+     * \brief m_renamed_paths
+     * \details
+     * The source and dest paths renamed by renameNatively(), they are renamed
+     * back if the operation is cancelled.
+     */
+    QList<QPair<QByteArray, QByteArray>> m_renamed_paths;
+
     std::shared_ptr<FileOperationInfo> m_info = nullptr;
 };
 
@@ -0,0 +1,32 @@
+#include "file-node-arena.h"
+#include "file-node.h"
+
+using namespace Peony;
+
+FileNodeArena::FileNodeArena()
+{
+
+}
+
+FileNodeArena::~FileNodeArena()
+{
+    for (int i = 0; i < m_blocks.count(); i++) {
+        auto nodes = reinterpret_cast<FileNode*>(m_blocks.at(i));
+        int count = i == m_blocks.count() - 1? m_used_count: BlockSize;
+        for (int j = 0; j < count; j++) {
+            nodes[j].~FileNode();
+        }
+        ::operator delete(m_blocks.at(i));
+    }
+    m_blocks.clear();
+}
+
+void *FileNodeArena::allocate()
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_used_count == BlockSize) {
+        m_blocks<<static_cast<char*>(::operator new(sizeof(FileNode)*BlockSize));
+        m_used_count = 0;
+    }
+    return m_blocks.last() + sizeof(FileNode)*(m_used_count++);
+}
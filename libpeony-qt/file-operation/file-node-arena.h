@@ -0,0 +1,55 @@
+#ifndef FILENODEARENA_H
+#define FILENODEARENA_H
+
+#include "peony-core_global.h"
+
+#include <QVector>
+#include <QMutex>
+
+namespace Peony {
+
+class FileNode;
+
+/*!
+ * \brief The FileNodeArena class
+ * <br>
+ * FileNodeArena is the storage of the nodes in a FileNode tree. The nodes are
+ * allocated in contiguous blocks rather than one heap object for each, and
+ * they are destroyed together with the arena. A huge tree is allocated and
+ * released in a few operations and does not fragment the heap.
+ * </br>
+ * \note
+ * The arena is owned by the root node, do not delete a node allocated from it.
+ * allocate() is thread safe, the children might be created by several scanning
+ * jobs at the same time.
+ * \see FileNode::createChild().
+ */
+class PEONYCORESHARED_EXPORT FileNodeArena
+{
+public:
+    FileNodeArena();
+    ~FileNodeArena();
+
+    /*!
+     * \brief allocate
+     * \return the uninitialized storage of a node, it should be constructed
+     * by placement new.
+     */
+    void *allocate();
+
+private:
+    static const int BlockSize = 1024;
+
+    QMutex m_mutex;
+    QVector<char*> m_blocks;
+    /*!
+     * \brief m_used_count
+     * \details
+     * The count of nodes allocated in the last block, the other blocks are full.
+     */
+    int m_used_count = BlockSize;
+};
+
+}
+
+#endif // FILENODEARENA_H
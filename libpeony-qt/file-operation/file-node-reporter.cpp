@@ -12,3 +12,17 @@ FileNodeReporter::~FileNodeReporter()
 {
 
 }
+
+void FileNodeReporter::addEnumerateError(const QString &uri, const GErrorWrapperPtr &err)
+{
+    QMutexLocker locker(&m_mutex);
+    m_enumerate_errors<<qMakePair(uri, err);
+}
+
+QList<QPair<QString, GErrorWrapperPtr>> FileNodeReporter::takeEnumerateErrors()
+{
+    QMutexLocker locker(&m_mutex);
+    auto errors = m_enumerate_errors;
+    m_enumerate_errors.clear();
+    return errors;
+}
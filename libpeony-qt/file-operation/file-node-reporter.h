@@ -2,9 +2,12 @@
 #define FILENODEREPORTER_H
 
 #include <QObject>
+#include <QMutex>
+#include <QPair>
 #include <memory>
 
 #include "peony-core_global.h"
+#include "gerror-wrapper.h"
 
 namespace Peony {
 
@@ -31,6 +34,18 @@ public:
     void cancel() {m_cancelled = true;}
     bool isOperationCancelled() {return m_cancelled;}
 
+    /*!
+     * \brief addEnumerateError
+     * \param uri, the directory which could not be enumerated completely.
+     * \param err
+     * <br>
+     * The directories are enumerated in other threads, the errors are recorded
+     * and the operation reports them by takeEnumerateErrors() after enumerating.
+     * </br>
+     */
+    void addEnumerateError(const QString &uri, const GErrorWrapperPtr &err);
+    QList<QPair<QString, GErrorWrapperPtr>> takeEnumerateErrors();
+
 Q_SIGNALS:
     void nodeFound(const QString &uri, const qint64 &offset);
     /*!
@@ -49,6 +64,9 @@ Q_SIGNALS:
 
 private:
     bool m_cancelled = false;
+
+    QMutex m_mutex;
+    QList<QPair<QString, GErrorWrapperPtr>> m_enumerate_errors;
 };
 
 }
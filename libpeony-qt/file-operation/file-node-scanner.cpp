@@ -0,0 +1,159 @@
+#include "file-node-scanner.h"
+#include "file-node.h"
+#include "file-node-reporter.h"
+
+#include <QThreadPool>
+#include <QThread>
+
+namespace Peony {
+
+/*!
+ * \brief The FileNodeScanJob class
+ * <br>
+ * A job of enumerating a directory in FileNodeScanner's pool.
+ * </br>
+ */
+class FileNodeScanJob : public QRunnable
+{
+public:
+    FileNodeScanJob(FileNodeScanner *scanner, FileNode *node) {
+        m_scanner = scanner;
+        m_node = node;
+    }
+
+    void run() override {
+        m_scanner->scanDirectory(m_node);
+    }
+
+private:
+    FileNodeScanner *m_scanner = nullptr;
+    FileNode *m_node = nullptr;
+};
+
+}
+
+using namespace Peony;
+
+FileNodeScanner::FileNodeScanner(FileNodeReporter *reporter, bool streaming)
+{
+    m_reporter = reporter;
+    m_streaming = streaming;
+    m_cancellable = g_cancellable_new();
+
+    m_pool = new QThreadPool;
+    //the enumeration is mostly waiting for io.
+    m_pool->setMaxThreadCount(qBound(2, QThread::idealThreadCount(), 8));
+}
+
+FileNodeScanner::~FileNodeScanner()
+{
+    cancel();
+    m_pool->waitForDone();
+    delete m_pool;
+    g_object_unref(m_cancellable);
+}
+
+void FileNodeScanner::start(FileNode *root)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_streaming) {
+        m_queue.enqueue(root);
+        m_condition.wakeAll();
+    }
+    if (root->isFolder()) {
+        m_pending_count++;
+        m_pool->start(new FileNodeScanJob(this, root));
+    }
+}
+
+void FileNodeScanner::cancel()
+{
+    g_cancellable_cancel(m_cancellable);
+}
+
+void FileNodeScanner::waitForFinished()
+{
+    QMutexLocker locker(&m_mutex);
+    while (m_pending_count > 0) {
+        m_condition.wait(&m_mutex);
+    }
+}
+
+bool FileNodeScanner::isFinished()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_pending_count == 0;
+}
+
+FileNode *FileNodeScanner::takeNode()
+{
+    QMutexLocker locker(&m_mutex);
+    while (m_queue.isEmpty() && m_pending_count > 0) {
+        m_condition.wait(&m_mutex);
+    }
+    if (m_queue.isEmpty())
+        return nullptr;
+    return m_queue.dequeue();
+}
+
+void FileNodeScanner::scanDirectory(FileNode *node)
+{
+    QList<FileNode*> children;
+    bool cancelled = g_cancellable_is_cancelled(m_cancellable) ||
+            (m_reporter && m_reporter->isOperationCancelled());
+
+    GFile *dir = g_file_new_for_uri(node->uri().toUtf8().constData());
+    GFileEnumerator *enumerator = nullptr;
+    GError *err = nullptr;
+    if (!cancelled) {
+        //use G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS to avoid unnecessary recursion.
+        enumerator = g_file_enumerate_children(dir,
+                                               G_FILE_ATTRIBUTE_STANDARD_NAME ","
+                                               G_FILE_ATTRIBUTE_STANDARD_TYPE ","
+                                               G_FILE_ATTRIBUTE_STANDARD_SIZE,
+                                               G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                               m_cancellable,
+                                               &err);
+    }
+    g_object_unref(dir);
+
+    if (enumerator) {
+        GFileInfo *info = nullptr;
+        while ((info = g_file_enumerator_next_file(enumerator, m_cancellable, &err))) {
+            bool isFolder = g_file_info_get_file_type(info) == G_FILE_TYPE_DIRECTORY;
+            auto childNode = FileNode::createChild(node,
+                                                   g_file_info_get_name(info),
+                                                   isFolder,
+                                                   g_file_info_get_size(info));
+            g_object_unref(info);
+            children<<childNode;
+
+            if (m_reporter && m_reporter->isOperationCancelled())
+                break;
+        }
+        g_object_unref(enumerator);
+    }
+    node->children()->append(children);
+
+    if (err) {
+        //the directory is not empty, it is unreadable or vanished.
+        node->m_incomplete = true;
+        if (err->code != G_IO_ERROR_CANCELLED && m_reporter) {
+            m_reporter->addEnumerateError(node->uri(), GErrorWrapper::wrapFrom(err));
+        } else {
+            g_error_free(err);
+        }
+    }
+
+    QMutexLocker locker(&m_mutex);
+    for (auto child : children) {
+        if (m_streaming)
+            m_queue.enqueue(child);
+        if (child->isFolder()) {
+            m_pending_count++;
+            m_pool->start(new FileNodeScanJob(this, child));
+        }
+    }
+    m_pending_count--;
+    m_condition.wakeAll();
+}
@@ -0,0 +1,88 @@
+#ifndef FILENODESCANNER_H
+#define FILENODESCANNER_H
+
+#include "peony-core_global.h"
+
+#include <QQueue>
+#include <QMutex>
+#include <QWaitCondition>
+#include <gio/gio.h>
+
+class QThreadPool;
+
+namespace Peony {
+
+class FileNode;
+class FileNodeReporter;
+
+/*!
+ * \brief The FileNodeScanner class
+ * <br>
+ * FileNodeScanner discovers the children of FileNode trees. Each directory is
+ * enumerated once with the name, type and size of its children, so that a child
+ * node is created without any other query. The directories are scanned by
+ * a pool of threads, a found sub directory is scanned by another job.
+ * </br>
+ * <br>
+ * The scanner could stream the found nodes. takeNode() returns the nodes in
+ * the order they were found, a node is always taken after its parent, so that
+ * an operation could start handling the nodes before the scan finished.
+ * </br>
+ * \note
+ * The children list of a folder node is filled by the scanning job, do not
+ * iterate it before the scan finished.
+ * \see FileNode::findChildrenRecursively().
+ */
+class PEONYCORESHARED_EXPORT FileNodeScanner
+{
+    friend class FileNodeScanJob;
+public:
+    /*!
+     * \brief FileNodeScanner
+     * \param reporter, the reporter of found nodes, it could be null.
+     * \param streaming, if true, the found nodes should be taken by takeNode().
+     */
+    explicit FileNodeScanner(FileNodeReporter *reporter = nullptr, bool streaming = false);
+    ~FileNodeScanner();
+
+    /*!
+     * \brief start
+     * \param root, the root of tree, it could be called for several roots.
+     */
+    void start(FileNode *root);
+    void cancel();
+    void waitForFinished();
+    bool isFinished();
+
+    /*!
+     * \brief takeNode
+     * \return the next found node, or null if the scan has finished and all nodes
+     * have been taken. This will block until there is a node found.
+     */
+    FileNode *takeNode();
+
+protected:
+    void scanDirectory(FileNode *node);
+
+private:
+    FileNodeReporter *m_reporter = nullptr;
+    bool m_streaming = false;
+
+    GCancellable *m_cancellable = nullptr;
+    QThreadPool *m_pool = nullptr;
+
+    QMutex m_mutex;
+    QWaitCondition m_condition;
+    QQueue<FileNode*> m_queue;
+    /*!
+     * \brief m_pending_count
+     * \details
+     * The count of directories found but not scanned, the scan is finished when
+     * it becomes 0.
+     */
+    int m_pending_count = 0;
+};
+
+}
+
+#endif // FILENODESCANNER_H
@@ -1,7 +1,11 @@
 #include "file-node.h"
-#include "file-enumerator.h"
-#include "file-info.h"
 #include "file-node-reporter.h"
+#include "file-node-scanner.h"
+#include "file-node-arena.h"
+
+#include <QVarLengthArray>
+
+#include <new>
 
 using namespace Peony;
 
@@ -11,34 +15,129 @@ FileNode::FileNode(QString uri, FileNode *parent, FileNodeReporter *reporter)
     m_parent = parent;
     m_reporter = reporter;
     GFile *file = g_file_new_for_uri(uri.toUtf8().constData());
-    char *basename = g_file_get_basename(file);
-    m_basename = basename;
-    g_free(basename);
 
     //use G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS to avoid unnecessary recursion.
-    m_is_folder = g_file_query_file_type(file, G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, nullptr) == G_FILE_TYPE_DIRECTORY;
     GFileInfo *info = g_file_query_info(file,
+                                        G_FILE_ATTRIBUTE_STANDARD_TYPE ","
                                         G_FILE_ATTRIBUTE_STANDARD_SIZE,
-                                        G_FILE_QUERY_INFO_NONE,
+                                        G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
                                         nullptr,
                                         nullptr);
     g_object_unref(file);
-    m_size = g_file_info_get_size(info);
-    g_object_unref(info);
+    if (info) {
+        m_is_folder = g_file_info_get_file_type(info) == G_FILE_TYPE_DIRECTORY;
+        m_size = g_file_info_get_size(info);
+        g_object_unref(info);
+    }
 
     if (m_reporter) {
         m_reporter->sendNodeFound(m_uri, m_size);
     }
+}
 
-    m_children = new QList<FileNode*>();
+FileNode::FileNode(FileNode *parent, const char *segment, bool isFolder, goffset size)
+{
+    m_uri = segment;
+    m_parent = parent;
+    m_reporter = parent->m_reporter;
+    m_arena = parent->m_arena;
+    m_is_folder = isFolder;
+    m_size = size;
 }
 
 FileNode::~FileNode() {
-    for (auto child : *m_children) {
-        delete child;
+    //the children are destroyed by the arena.
+    if (!m_parent)
+        delete m_arena;
+}
+
+FileNode *FileNode::createChild(FileNode *parent, const char *name, bool isFolder, goffset size)
+{
+    if (!parent->m_arena) {
+        //only root has no arena.
+        parent->m_arena = new FileNodeArena;
+    }
+
+    char *segment = g_uri_escape_string(name, G_URI_RESERVED_CHARS_ALLOWED_IN_PATH_ELEMENT, FALSE);
+    auto node = new (parent->m_arena->allocate()) FileNode(parent, segment, isFolder, size);
+    g_free(segment);
+
+    if (node->m_reporter) {
+        node->m_reporter->sendNodeFound(node->uri(), node->m_size);
+    }
+    return node;
+}
+
+QString FileNode::buildUri(const QString &rootUri)
+{
+    //collect the segments up to root, so that the uri is allocated once.
+    QVarLengthArray<FileNode*, 64> nodes;
+    int length = rootUri.length();
+    for (FileNode *n = this; n->m_parent; n = n->m_parent) {
+        nodes.append(n);
+        length += n->m_uri.length() + 1;
     }
-    m_children->clear();
-    delete m_children;
+
+    QString uri;
+    uri.reserve(length);
+    uri.append(rootUri);
+    for (int i = nodes.count() - 1; i >= 0; i--) {
+        if (!uri.endsWith('/'))
+            uri.append('/');
+        uri.append(nodes.at(i)->m_uri);
+    }
+    return uri;
+}
+
+FileNode *FileNode::root()
+{
+    FileNode *node = this;
+    while (node->m_parent)
+        node = node->m_parent;
+    return node;
+}
+
+QString FileNode::uri()
+{
+    if (!m_parent)
+        return m_uri;
+    return buildUri(root()->m_uri);
+}
+
+QString FileNode::destUri()
+{
+    if (!m_parent)
+        return m_dest_uri;
+
+    QString rootDestUri = root()->m_dest_uri;
+    if (rootDestUri.isEmpty())
+        return rootDestUri;
+    return buildUri(rootDestUri);
+}
+
+void FileNode::setDestUri(QString uri)
+{
+    //only root keeps its dest uri, the children's are built from it.
+    if (m_parent)
+        return;
+    m_dest_uri = uri;
+}
+
+QString FileNode::baseName()
+{
+    if (m_parent) {
+        char *name = g_uri_unescape_string(m_uri.toUtf8().constData(), nullptr);
+        QString baseName = name;
+        g_free(name);
+        return baseName;
+    }
+
+    GFile *file = g_file_new_for_uri(m_uri.toUtf8().constData());
+    char *basename = g_file_get_basename(file);
+    QString baseName = basename;
+    g_free(basename);
+    g_object_unref(file);
+    return baseName;
 }
 
 void FileNode::findChildrenRecursively()
@@ -50,44 +149,26 @@ void FileNode::findChildrenRecursively()
 
     if (!m_is_folder)
         return;
-    else {
-        FileEnumerator e;
-        e.setEnumerateDirectory(m_uri);
-        e.enumerateSync();
-        auto infos = e.getChildren();
-        for (auto info: infos) {
-            FileNode *node = new FileNode(info->uri(), this, m_reporter);
-            m_children->append(node);
-            node->findChildrenRecursively();
-        }
-    }
+
+    FileNodeScanner scanner(m_reporter);
+    scanner.start(this);
+    scanner.waitForFinished();
 }
 
 void FileNode::computeTotalSize(goffset *offset)
 {
     *offset += m_size;
-    for (auto child : *m_children) {
+    for (auto child : m_children) {
         child->computeTotalSize(offset);
     }
 }
 
 QString FileNode::getRelativePath()
 {
-    FileNode *n = this;
-    while (n->m_parent) {
-        n = n->m_parent;
+    //the relative path from root's parent, it is built from the names.
+    QStringList names;
+    for (FileNode *n = this; n; n = n->m_parent) {
+        names.prepend(n->baseName());
     }
-    GFile *root_file = g_file_new_for_uri(n->m_uri.toUtf8().constData());
-    GFile *root_file_parent = g_file_get_parent(root_file);
-    GFile *this_file = g_file_new_for_uri(m_uri.toUtf8().constData());
-
-    char *relative_path = g_file_get_relative_path(root_file_parent, this_file);
-    QString relativePath = relative_path;
-
-    g_free(relative_path);
-    g_object_unref(root_file);
-    g_object_unref(root_file_parent);
-    g_object_unref(this_file);
-
-    return relativePath;
+    return names.join('/');
 }
@@ -11,6 +11,7 @@
 namespace Peony {
 
 class FileNodeReporter;
+class FileNodeArena;
 
 /*!
  * \brief The FileNode class
@@ -32,11 +33,18 @@ class FileNodeReporter;
  * of file node enumeration. Actually, a FileNode instance always be with a FileNodeReproter
  * instance at its initialization.
  * </br>
- * \see FileNodeReporter.
+ * <br>
+ * A tree might have millions of nodes. The nodes except root are allocated in the
+ * root's FileNodeArena, and only the root keeps its whole uri and dest uri. The
+ * others keep the escaped uri segment of their names, and their uris and dest
+ * uris are built by walking up to the root on demand.
+ * </br>
+ * \see FileNodeReporter, FileNodeArena.
  */
 class PEONYCORESHARED_EXPORT FileNode
 {
     friend class FileNodeReporter;
+    friend class FileNodeScanner;
 public:
     enum State {
         Unhandled,
@@ -45,22 +53,60 @@ public:
         Invalid
     };
 
+    /*!
+     * \brief FileNode
+     * \param uri
+     * \param parent, it should be null, use createChild() for children.
+     * \param reporter
+     */
     FileNode(QString uri, FileNode* parent, FileNodeReporter *reporter = nullptr);
     ~FileNode();
 
-    //FIXME: do i need add cancel function?
+    /*!
+     * \brief createChild
+     * \param parent
+     * \param name, the basename of child.
+     * \param isFolder
+     * \param size
+     * <br>
+     * Create a child node in the root's arena with the info which has been enumerated,
+     * it does not query the file. The child is not appended to the parent's children.
+     * </br>
+     * \see FileNodeScanner.
+     */
+    static FileNode *createChild(FileNode *parent, const char *name, bool isFolder, goffset size);
+
+    /*!
+     * \brief findChildrenRecursively
+     * <br>
+     * Scan the tree with FileNodeScanner and wait for it finished. The reporter's
+     * cancellation stops the scan.
+     * </br>
+     */
     void findChildrenRecursively();
     void computeTotalSize(goffset *offset);
 
-    QString uri() {return m_uri;}
-    QString destUri() {return m_dest_uri;}
+    QString uri();
+    /*!
+     * \brief destUri
+     * \return the dest uri of root, or the dest uri built from the parent's.
+     * It is empty if the root's dest uri has not been set.
+     */
+    QString destUri();
     State state() {return m_state;}
     FileOperation::ResponseType responseType() {return m_err_response;}
-    QString baseName() {return m_basename;}
+    QString baseName();
     FileNode *parent() {return m_parent;}
-    QList<FileNode*> *children() {return m_children;}
+    QList<FileNode*> *children() {return &m_children;}
     qint64 size() {return m_size;}
     bool isFolder() {return m_is_folder;}
+    /*!
+     * \brief isIncomplete
+     * \return true if the folder could not be enumerated completely, its
+     * children are not all in the tree.
+     * \see FileNodeReporter::takeEnumerateErrors().
+     */
+    bool isIncomplete() {return m_incomplete;}
 
     QString getRelativePath();
 
@@ -73,12 +119,13 @@ public:
      * We should create a list of node trees for the files which have been copied or moved
      * for 'recover' them to the previous uri.
      * Dest uri is set when the file has been copied or moved to dest location.
+     * It only takes effect for root, a child's dest uri is built from the root's.
      * This will aslo changed the node states. The rollback function will determine how to roll back
      * based on the status of dest uri and current states.
      * </br>
      * \see setState().
      */
-    void setDestUri(QString uri) {m_dest_uri = uri;}
+    void setDestUri(QString uri);
     /*!
      * \brief setState
      * \param state
@@ -105,18 +152,43 @@ public:
      */
     void setErrorResponse(FileOperation::ResponseType type) {m_err_response = type;}
 private:
+    FileNode(FileNode *parent, const char *segment, bool isFolder, goffset size);
+    FileNode *root();
+    /*!
+     * \brief buildUri
+     * \param rootUri, the uri or dest uri of root.
+     * \return the uri of this node under rootUri, joined from the segments.
+     */
+    QString buildUri(const QString &rootUri);
+
+    /*!
+     * \brief m_uri
+     * \details
+     * The whole uri of root, or the escaped uri segment of a child's name.
+     */
     QString m_uri = nullptr;
-    QString m_basename = nullptr;
     goffset m_size = 0;
     bool m_is_folder = false;
+    bool m_incomplete = false;
     FileNode *m_parent = nullptr;
-    QList<FileNode*> *m_children = nullptr;
+    QList<FileNode*> m_children;
 
+    /*!
+     * \brief m_dest_uri
+     * \details
+     * It is only set for root.
+     */
     QString m_dest_uri = nullptr;
     State m_state = Unhandled;
     FileOperation::ResponseType m_err_response = FileOperation::Other;
 
     FileNodeReporter *m_reporter = nullptr;
+    /*!
+     * \brief m_arena
+     * \details
+     * The arena of tree, it is owned by root and created with the first child.
+     */
+    FileNodeArena *m_arena = nullptr;
 };
 
 }
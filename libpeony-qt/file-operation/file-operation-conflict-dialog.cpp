@@ -0,0 +1,97 @@
+#include "file-operation-conflict-dialog.h"
+
+#include <QFormLayout>
+#include <QLabel>
+#include <QListWidget>
+#include <QComboBox>
+#include <QDialogButtonBox>
+#include <QPushButton>
+
+//the list is only a sample, a huge list stalls the ui.
+#define MAX_LISTED_CONFLICTS 100
+
+using namespace Peony;
+
+FileOperationConflictDialog::FileOperationConflictDialog(QWidget *parent) : QDialog(parent)
+{
+    setWindowTitle(tr("File Operation Conflicts"));
+    setWindowIcon(QIcon::fromTheme("dialog-warning"));
+    m_layout = new QFormLayout(this);
+    m_layout->setFieldGrowthPolicy(QFormLayout::FieldsStayAtSizeHint);
+    m_layout->setLabelAlignment(Qt::AlignRight);
+    m_layout->setFormAlignment(Qt::AlignLeft);
+
+    m_state_line = new QLabel(this);
+    m_layout->addRow(m_state_line);
+
+    m_conflicts_list = new QListWidget(this);
+    m_conflicts_list->setMaximumHeight(150);
+    m_layout->addRow(m_conflicts_list);
+
+    m_button_box = new QDialogButtonBox(this);
+    m_button_box->addButton(tr("&Apply"), QDialogButtonBox::AcceptRole);
+    m_button_box->addButton(tr("&Cancel"), QDialogButtonBox::RejectRole);
+    connect(m_button_box, &QDialogButtonBox::accepted, this, &QDialog::accept);
+    connect(m_button_box, &QDialogButtonBox::rejected, this, &QDialog::reject);
+
+    setLayout(m_layout);
+}
+
+FileOperationConflictDialog::~FileOperationConflictDialog()
+{
+
+}
+
+QVariant FileOperationConflictDialog::handleConflicts(const QList<FileOperationConflict> &conflicts)
+{
+    m_state_line->setText(tr("%1 files could not be handled, choose how to resolve them:").arg(conflicts.count()));
+
+    //one rule for each kind of error.
+    QHash<int, int> counts;
+    QHash<int, QString> messages;
+    QList<int> codes;
+    for (auto conflict : conflicts) {
+        int code = conflict.err->code();
+        if (!counts.contains(code)) {
+            codes<<code;
+            messages.insert(code, conflict.err->message());
+        }
+        counts[code]++;
+        if (m_conflicts_list->count() < MAX_LISTED_CONFLICTS)
+            m_conflicts_list->addItem(QString("%1: %2").arg(conflict.srcUri).arg(conflict.err->message()));
+    }
+    if (conflicts.count() > MAX_LISTED_CONFLICTS)
+        m_conflicts_list->addItem(tr("... and %1 more").arg(conflicts.count() - MAX_LISTED_CONFLICTS));
+
+    for (auto code : codes) {
+        QString message = messages.value(code);
+
+        QComboBox *ruleBox = new QComboBox(this);
+        ruleBox->addItem(tr("Skip"), FileOperation::IgnoreAll);
+        if (code == G_IO_ERROR_EXISTS) {
+            ruleBox->addItem(tr("Overwrite"), FileOperation::OverWriteAll);
+            ruleBox->addItem(tr("Overwrite if newer"), FileOperation::OverWriteNewer);
+            ruleBox->addItem(tr("Backup"), FileOperation::BackupAll);
+        }
+        ruleBox->addItem(tr("Retry"), FileOperation::Retry);
+        m_rule_boxes.insert(code, ruleBox);
+
+        QLabel *label = new QLabel(tr("%1 (%2 files)").arg(message).arg(counts.value(code)), this);
+        label->setWordWrap(true);
+        m_layout->addRow(label, ruleBox);
+    }
+    m_layout->addRow(m_button_box);
+
+    FileOperation::ConflictRules rules;
+    if (exec() == QDialog::Accepted) {
+        for (auto code : codes) {
+            auto ruleBox = m_rule_boxes.value(code);
+            rules.insert(code, FileOperation::ResponseType(ruleBox->currentData().toInt()));
+        }
+    } else {
+        for (auto code : codes) {
+            rules.insert(code, FileOperation::Cancel);
+        }
+    }
+    return QVariant::fromValue(rules);
+}
@@ -0,0 +1,52 @@
+#ifndef FILEOPERATIONCONFLICTDIALOG_H
+#define FILEOPERATIONCONFLICTDIALOG_H
+
+#include <QDialog>
+#include "file-operation.h"
+
+class QFormLayout;
+class QLabel;
+class QListWidget;
+class QComboBox;
+class QDialogButtonBox;
+
+namespace Peony {
+
+/*!
+ * \brief The FileOperationConflictDialog class
+ * <br>
+ * This dialog resolves the conflicts parked by an operation in deferred-conflict
+ * mode in bulk. The conflicts are grouped by their errors, and the user chooses
+ * one rule for each kind of error, such as "overwrite if newer" for the existed
+ * targets and "skip" for the permission errors.
+ * </br>
+ * \see FileOperation::conflictsDeferred(), FileOperationErrorDialog.
+ */
+class PEONYCORESHARED_EXPORT FileOperationConflictDialog : public QDialog
+{
+    Q_OBJECT
+public:
+    explicit FileOperationConflictDialog(QWidget *parent = nullptr);
+    ~FileOperationConflictDialog() override;
+
+public Q_SLOTS:
+    /*!
+     * \brief handleConflicts
+     * \param conflicts
+     * \return the FileOperation::ConflictRules chosen by user.
+     * If the dialog was cancelled, the rules contain Cancel.
+     */
+    QVariant handleConflicts(const QList<Peony::FileOperationConflict> &conflicts);
+
+private:
+    QFormLayout *m_layout = nullptr;
+    QLabel *m_state_line = nullptr;
+    QListWidget *m_conflicts_list = nullptr;
+    QDialogButtonBox *m_button_box = nullptr;
+
+    QHash<int, QComboBox*> m_rule_boxes;
+};
+
+}
+
+#endif // FILEOPERATIONCONFLICTDIALOG_H
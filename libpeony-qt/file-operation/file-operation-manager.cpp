@@ -1,6 +1,10 @@
 #include "file-operation-manager.h"
 #include "file-operation.h"
-#include <QMessageBox>
+#include <QThread>
+#include <QTimer>
+#include <QUrl>
+
+#include <gio/gunixmounts.h>
 
 #include "file-copy-operation.h"
 #include "file-delete-operation.h"
@@ -11,24 +15,232 @@
 #include "file-untrash-operation.h"
 
 #include "file-operation-error-dialog.h"
+#include "file-operation-conflict-dialog.h"
 #include "file-operation-progress-wizard.h"
+#include "trash-index.h"
+
+namespace Peony {
+
+/*!
+ * \brief The FileOperationJob class
+ * <br>
+ * A job of executing an operation in FileOperationManager's pool. It tells the
+ * manager to release the devices of operation when the operation returned, even
+ * if the operation did not send operationFinished().
+ * </br>
+ */
+class FileOperationJob : public QRunnable
+{
+public:
+    FileOperationJob(FileOperationManager *manager, FileOperation *operation, int jobId) {
+        m_manager = manager;
+        m_operation = operation;
+        m_job_id = jobId;
+    }
+
+    void run() override {
+        m_operation->run();
+        if (m_operation->autoDelete())
+            delete m_operation;
+        QMetaObject::invokeMethod(m_manager, "onOperationJobFinished", Qt::QueuedConnection, Q_ARG(int, m_job_id));
+    }
+
+private:
+    FileOperationManager *m_manager = nullptr;
+    FileOperation *m_operation = nullptr;
+    int m_job_id = 0;
+};
+
+}
 
 using namespace Peony;
 
 static FileOperationManager *global_instance = nullptr;
 
+/*!
+ * \brief deviceOfUri
+ * \return the key of device which the file is on.
+ * <br>
+ * A local file is keyed by its device number, an inexistent file uses its
+ * nearest existed parent's. A remote file is keyed by its scheme and host.
+ * </br>
+ */
+static QString deviceOfUri(const QString &uri)
+{
+    QString device;
+    GFile *file = g_file_new_for_uri(uri.toUtf8().constData());
+    if (g_file_is_native(file)) {
+        GFile *current = G_FILE(g_object_ref(file));
+        while (current && device.isNull()) {
+            GFileInfo *info = g_file_query_info(current,
+                                                G_FILE_ATTRIBUTE_UNIX_DEVICE,
+                                                G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                                nullptr,
+                                                nullptr);
+            if (info) {
+                device = QString("dev:%1").arg(g_file_info_get_attribute_uint32(info, G_FILE_ATTRIBUTE_UNIX_DEVICE));
+                g_object_unref(info);
+            } else {
+                GFile *parent = g_file_get_parent(current);
+                g_object_unref(current);
+                current = parent;
+            }
+        }
+        if (current)
+            g_object_unref(current);
+    }
+    g_object_unref(file);
+
+    if (device.isNull()) {
+        QUrl url(uri);
+        device = url.scheme() + "://" + url.host();
+    }
+    return device;
+}
+
+/*!
+ * \brief restoredUriOf
+ * \return the uri which a trashed item is restored onto, or the uri itself if
+ * it is not a trashed item.
+ * <br>
+ * The items in home trash are looked up in TrashIndex, the others are queried
+ * by the trash backend.
+ * </br>
+ */
+static QString restoredUriOf(const QString &uri)
+{
+    if (!uri.startsWith("trash:///"))
+        return uri;
+
+    QString originPath = TrashIndex::getInstance()->originalPath(uri);
+    if (originPath.isNull()) {
+        GFile *file = g_file_new_for_uri(uri.toUtf8().constData());
+        GFileInfo *info = g_file_query_info(file,
+                                            G_FILE_ATTRIBUTE_TRASH_ORIG_PATH,
+                                            G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                            nullptr,
+                                            nullptr);
+        if (info) {
+            const char *path = g_file_info_get_attribute_byte_string(info, G_FILE_ATTRIBUTE_TRASH_ORIG_PATH);
+            if (path)
+                originPath = QString::fromLocal8Bit(path);
+            g_object_unref(info);
+        }
+        g_object_unref(file);
+    }
+    if (originPath.isNull())
+        return uri;
+
+    GFile *origin = g_file_new_for_path(originPath.toLocal8Bit().constData());
+    char *origin_uri = g_file_get_uri(origin);
+    QString restoredUri = origin_uri;
+    g_free(origin_uri);
+    g_object_unref(origin);
+    return restoredUri;
+}
+
+/*!
+ * \brief devicesOfUris
+ * \return the keys of devices which the files are on.
+ * <br>
+ * The children of a directory are on its device except the mount points, so
+ * the device is queried once for every parent directory, and the mount points
+ * are resolved by themselves. A trashed item is keyed by the device which it
+ * is restored onto.
+ * </br>
+ */
+static QStringList devicesOfUris(const QStringList &uris)
+{
+    QSet<QString> mountPaths;
+    GList *mounts = g_unix_mounts_get(nullptr);
+    for (GList *l = mounts; l; l = l->next) {
+        mountPaths<<QString::fromLocal8Bit(g_unix_mount_get_mount_path(static_cast<GUnixMountEntry *>(l->data)));
+    }
+    g_list_free_full(mounts, GDestroyNotify(g_unix_mount_free));
+
+    QHash<QString, QString> dirDevices;
+    QStringList devices;
+    for (auto trashOrUri : uris) {
+        QString uri = restoredUriOf(trashOrUri);
+        QString key = uri;
+        GFile *file = g_file_new_for_uri(uri.toUtf8().constData());
+        char *path = g_file_get_path(file);
+        bool isMountPoint = path && mountPaths.contains(QString::fromLocal8Bit(path));
+        g_free(path);
+        GFile *parent = isMountPoint? nullptr: g_file_get_parent(file);
+        if (parent) {
+            char *parent_uri = g_file_get_uri(parent);
+            key = parent_uri;
+            g_free(parent_uri);
+            g_object_unref(parent);
+        }
+        g_object_unref(file);
+
+        if (!dirDevices.contains(key))
+            dirDevices.insert(key, deviceOfUri(key));
+        QString device = dirDevices.value(key);
+        if (!devices.contains(device))
+            devices<<device;
+    }
+    return devices;
+}
+
+namespace Peony {
+
+/*!
+ * \brief The FileOperationDeviceJob class
+ * <br>
+ * A job of resolving the devices of a queued operation. It might query every
+ * parent directory of the sources, or block on a hung mount, so it does not
+ * run in ui thread.
+ * </br>
+ */
+class FileOperationDeviceJob : public QRunnable
+{
+public:
+    FileOperationDeviceJob(FileOperationManager *manager, const QStringList &uris, int resolveId) {
+        m_manager = manager;
+        m_uris = uris;
+        m_resolve_id = resolveId;
+    }
+
+    void run() override {
+        QStringList devices = devicesOfUris(m_uris);
+        QMetaObject::invokeMethod(m_manager, "onOperationDevicesResolved", Qt::QueuedConnection,
+                                  Q_ARG(int, m_resolve_id), Q_ARG(QStringList, devices));
+    }
+
+private:
+    FileOperationManager *m_manager = nullptr;
+    QStringList m_uris;
+    int m_resolve_id = 0;
+};
+
+}
+
 FileOperationManager::FileOperationManager(QObject *parent) : QObject(parent)
 {
     qRegisterMetaType<Peony::GErrorWrapperPtr>("Peony::GErrorWrapperPtr");
     qRegisterMetaType<Peony::GErrorWrapperPtr>("Peony::GErrorWrapperPtr&");
+    qRegisterMetaType<QList<Peony::FileOperationConflict>>("QList<Peony::FileOperationConflict>");
+    qRegisterMetaType<Peony::FileOperation::ConflictRules>("Peony::FileOperation::ConflictRules");
     m_thread_pool = new QThreadPool(this);
-    //Imitating queue execution.
-    m_thread_pool->setMaxThreadCount(1);
+    //the operations on the same device are queued by the manager,
+    //so the threads are only shared by different devices.
+    m_thread_pool->setMaxThreadCount(qMax(4, QThread::idealThreadCount()));
+    //a hung mount only blocks the operations on it, the others are
+    //resolved by other threads and scheduled past it.
+    m_device_pool = new QThreadPool(this);
+    m_device_pool->setMaxThreadCount(4);
 }
 
 FileOperationManager::~FileOperationManager()
 {
-
+    for (auto operation : m_queued_operations) {
+        if (operation->autoDelete())
+            delete operation;
+    }
+    m_queued_operations.clear();
 }
 
 FileOperationManager *FileOperationManager::getInstance()
@@ -49,45 +261,25 @@ void FileOperationManager::close()
 
 void FileOperationManager::startOperation(FileOperation *operation, bool addToHistory)
 {
-    if (m_thread_pool->activeThreadCount() > 0) {
-        QMessageBox::warning(nullptr,
-                             tr("File Operation is Busy"),
-                             tr("There have been one or more file"
-                                "operation(s) executing before. Your"
-                                "operation will wait for executing"
-                                "until it/them done."));
-    }
-
-    FileOperationProgressWizard *wizard = new FileOperationProgressWizard;
-    wizard->connect(operation, &FileOperation::operationRequestShowWizard, wizard, &FileOperationProgressWizard::show);
-    wizard->connect(operation, &FileOperation::operationRequestShowWizard, wizard, &FileOperationProgressWizard::switchToPreparedPage);
-    wizard->connect(operation, &FileOperation::operationPreparedOne, wizard, &FileOperationProgressWizard::onElementFoundOne);
-    wizard->connect(operation, &FileOperation::operationPrepared, wizard, &FileOperationProgressWizard::onElementFoundAll);
-    wizard->connect(operation, &FileOperation::operationProgressedOne, wizard, &FileOperationProgressWizard::onFileOperationProgressedOne);
-    wizard->connect(operation, &FileOperation::operationProgressed, wizard, &FileOperationProgressWizard::onFileOperationProgressedAll);
-    wizard->connect(operation, &FileOperation::operationAfterProgressedOne, wizard, &FileOperationProgressWizard::onElementClearOne);
-    wizard->connect(operation, &FileOperation::operationAfterProgressed, wizard, &FileOperationProgressWizard::switchToRollbackPage);
-    wizard->connect(operation, &FileOperation::operationRollbackedOne, wizard, &FileOperationProgressWizard::onFileRollbacked);
-    wizard->connect(operation, &FileOperation::operationFinished, wizard, &FileOperationProgressWizard::deleteLater);
-
-    connect(wizard, &Peony::FileOperationProgressWizard::cancelled,
-            operation, &Peony::FileOperation::cancel);
+    //only copy parks the failed items to resolve them in bulk.
+    if (qobject_cast<FileCopyOperation *>(operation))
+        operation->setConflictsDeferred();
 
     operation->connect(operation, &FileOperation::errored, [=](){
         operation->setHasError(true);
     });
-
-    operation->connect(operation, &FileOperation::errored,
-                       this, &FileOperationManager::handleError,
-                       Qt::BlockingQueuedConnection);
+    operation->connect(operation, &FileOperation::conflictsDeferred, [=](){
+        operation->setHasError(true);
+    });
 
     operation->connect(operation, &FileOperation::operationFinished, [=](){
         if (operation->hasError()) {
             return ;
         }
 
-        if (addToHistory) {
-            auto info = operation->getOperationInfo();
+        //an operation might resolve its info in run(), it is read after finished.
+        auto info = addToHistory? operation->getOperationInfo(): nullptr;
+        if (info) {
             if (info->operationType() != FileOperationInfo::Delete) {
                 m_undo_stack.push(info);
                 m_redo_stack.clear();
@@ -97,7 +289,184 @@ void FileOperationManager::startOperation(FileOperation *operation, bool addToHi
         }
     });
 
-    m_thread_pool->start(operation);
+    //the operation is scheduled once its devices resolved.
+    int resolveId = ++m_last_resolve_id;
+    m_resolving_operations.insert(resolveId, operation);
+    m_queued_operations<<operation;
+    m_operation_wizards.insert(operation, createWizard(operation));
+    Q_EMIT queueChanged();
+
+    m_device_pool->start(new FileOperationDeviceJob(this, operation->involvedUris(), resolveId));
+    //do not flash the wizard for the operations which start at once.
+    QTimer::singleShot(500, this, &FileOperationManager::showQueuedOperations);
+}
+
+FileOperationProgressWizard *FileOperationManager::createWizard(FileOperation *operation)
+{
+    FileOperationProgressWizard *wizard = new FileOperationProgressWizard;
+    //the per-file progress is sampled by wizard rather than sent to it.
+    wizard->setProgress(operation->progress());
+    wizard->connect(operation, &FileOperation::operationRequestShowWizard, wizard, &FileOperationProgressWizard::show);
+    wizard->connect(operation, &FileOperation::operationRequestShowWizard, wizard, &FileOperationProgressWizard::switchToPreparedPage);
+    wizard->connect(operation, &FileOperation::operationPrepared, wizard, &FileOperationProgressWizard::onElementFoundAll);
+    wizard->connect(operation, &FileOperation::operationProgressed, wizard, &FileOperationProgressWizard::onFileOperationProgressedAll);
+    wizard->connect(operation, &FileOperation::operationAfterProgressed, wizard, &FileOperationProgressWizard::switchToRollbackPage);
+    wizard->connect(operation, &FileOperation::operationFinished, wizard, &FileOperationProgressWizard::deleteLater);
+    //a queued operation might be destroyed without running.
+    wizard->connect(operation, &QObject::destroyed, wizard, &FileOperationProgressWizard::deleteLater);
+
+    connect(wizard, &FileOperationProgressWizard::cancelled, operation, [=](){
+        if (m_queued_operations.contains(operation)) {
+            cancelQueuedOperation(operation);
+        } else {
+            operation->cancel();
+        }
+    });
+    connect(wizard, &FileOperationProgressWizard::pauseRequested, operation, [=](bool paused){
+        setOperationPaused(operation, paused);
+    });
+    connect(wizard, &FileOperationProgressWizard::moveToFrontRequested, operation, [=](){
+        moveQueuedOperation(operation, 0);
+    });
+    return wizard;
+}
+
+void FileOperationManager::showQueuedOperations()
+{
+    for (auto operation : m_queued_operations) {
+        auto wizard = m_operation_wizards.value(operation);
+        if (wizard)
+            wizard->setQueued();
+    }
+}
+
+void FileOperationManager::onOperationDevicesResolved(int resolveId, const QStringList &devices)
+{
+    //the operation might have been cancelled while resolving.
+    FileOperation *operation = m_resolving_operations.take(resolveId);
+    if (!operation)
+        return;
+
+    m_operation_devices.insert(operation, devices);
+    scheduleOperations();
+}
+
+void FileOperationManager::scheduleOperations()
+{
+    QSet<QString> occupiedDevices;
+    for (auto devices : m_running_devices) {
+        for (auto device : devices)
+            occupiedDevices<<device;
+    }
+
+    bool changed = false;
+    auto operations = m_queued_operations;
+    for (auto operation : operations) {
+        if (m_paused_operations.contains(operation))
+            continue;
+        //the devices are still resolving, it does not hold up the others.
+        if (!m_operation_devices.contains(operation))
+            continue;
+
+        QStringList devices = m_operation_devices.value(operation);
+        bool blocked = false;
+        for (auto device : devices) {
+            if (occupiedDevices.contains(device))
+                blocked = true;
+            //a waiting operation also holds its place in the queue of device.
+            occupiedDevices<<device;
+        }
+        if (blocked)
+            continue;
+
+        m_queued_operations.removeOne(operation);
+        m_operation_devices.remove(operation);
+        auto wizard = m_operation_wizards.take(operation);
+        changed = true;
+        if (operation->isCancelled()) {
+            if (wizard)
+                wizard->deleteLater();
+            if (operation->autoDelete())
+                delete operation;
+            continue;
+        }
+        if (wizard)
+            wizard->setQueued(false);
+        executeOperation(operation, devices);
+    }
+
+    if (changed)
+        Q_EMIT queueChanged();
+    //the resolved operations which are blocked are waiting.
+    for (auto operation : m_queued_operations) {
+        auto wizard = m_operation_wizards.value(operation);
+        if (wizard && m_operation_devices.contains(operation))
+            wizard->setQueued();
+    }
+}
+
+void FileOperationManager::executeOperation(FileOperation *operation, const QStringList &devices)
+{
+    operation->connect(operation, &FileOperation::errored,
+                       this, &FileOperationManager::handleError,
+                       Qt::BlockingQueuedConnection);
+    operation->connect(operation, &FileOperation::conflictsDeferred,
+                       this, &FileOperationManager::handleConflicts,
+                       Qt::BlockingQueuedConnection);
+
+    int jobId = ++m_last_job_id;
+    m_running_devices.insert(jobId, devices);
+    m_thread_pool->start(new FileOperationJob(this, operation, jobId));
+}
+
+void FileOperationManager::onOperationJobFinished(int jobId)
+{
+    m_running_devices.remove(jobId);
+    scheduleOperations();
+}
+
+void FileOperationManager::moveQueuedOperation(FileOperation *operation, int index)
+{
+    int from = m_queued_operations.indexOf(operation);
+    if (from < 0)
+        return;
+
+    m_queued_operations.move(from, qBound(0, index, m_queued_operations.count() - 1));
+    Q_EMIT queueChanged();
+    scheduleOperations();
+}
+
+void FileOperationManager::setOperationPaused(FileOperation *operation, bool paused)
+{
+    if (!m_queued_operations.contains(operation))
+        return;
+
+    if (paused) {
+        m_paused_operations<<operation;
+    } else {
+        m_paused_operations.remove(operation);
+    }
+    Q_EMIT queueChanged();
+    scheduleOperations();
+}
+
+void FileOperationManager::cancelQueuedOperation(FileOperation *operation)
+{
+    if (!m_queued_operations.removeOne(operation))
+        return;
+
+    m_operation_devices.remove(operation);
+    m_paused_operations.remove(operation);
+    auto wizard = m_operation_wizards.take(operation);
+    if (wizard)
+        wizard->deleteLater();
+    int resolveId = m_resolving_operations.key(operation, 0);
+    if (resolveId != 0)
+        m_resolving_operations.remove(resolveId);
+    if (operation->autoDelete())
+        delete operation;
+    Q_EMIT queueChanged();
+    scheduleOperations();
 }
 
 void FileOperationManager::startUndoOrRedo(std::shared_ptr<FileOperationInfo> info)
@@ -209,3 +578,9 @@ QVariant FileOperationManager::handleError(const QString &srcUri,
     FileOperationErrorDialog dlg;
     return dlg.handleError(srcUri, destUri, err, critical);
 }
+
+QVariant FileOperationManager::handleConflicts(const QList<FileOperationConflict> &conflicts)
+{
+    FileOperationConflictDialog dlg;
+    return dlg.handleConflicts(conflicts);
+}
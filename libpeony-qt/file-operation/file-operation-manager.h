@@ -11,10 +11,13 @@
 #include <QMutex>
 #include <QStack>
 #include <QThreadPool>
+#include <QSet>
+#include <QHash>
 
 namespace Peony {
 
 class FileOperationInfo;
+class FileOperationProgressWizard;
 
 /*!
  * \brief The FileOperationManager class
@@ -23,8 +26,15 @@ class FileOperationInfo;
  * And in peony-qt, it is similar to peony. But there are higher level
  * api to manage these 'managers' in peony-qt.
  * Not only the undo/redo stacks' management. FileOperationManager
- * only allows up to one file operation instace to run at same times,
- * this means the operations will be queue executed.
+ * also schedules the file operations. Every device has its own queue,
+ * an operation waits until the former operations on the devices it reads
+ * or writes have finished, while the operations on different devices are
+ * executed at the same time. For example, a copy to usb stick does not
+ * block a rename in home directory.
+ * The queued operations could be listed, reordered and paused. An operation
+ * which waits for the others is shown by its wizard in the queued state.
+ * The copy operations are started in deferred-conflict mode, the failed items
+ * do not block an operation, they are resolved in bulk at the end.
  * FileOperationManager will provide the operation-ui and error-handler-ui
  * which are implement as defaut in peony-qt's operation frameworks.
  * \note
@@ -39,12 +49,26 @@ class FileOperationInfo;
 class PEONYCORESHARED_EXPORT FileOperationManager : public QObject
 {
     Q_OBJECT
+    friend class FileOperationJob;
 public:
     static FileOperationManager *getInstance();
     void close();
 
+    /*!
+     * \brief queuedOperations
+     * \return the operations waiting for executing, in the order they will be started.
+     */
+    QList<FileOperation*> queuedOperations() {return m_queued_operations;}
+    bool isOperationPaused(FileOperation *operation) {return m_paused_operations.contains(operation);}
+
 Q_SIGNALS:
     void closed();
+    /*!
+     * \brief queueChanged
+     * \details
+     * This signal is sent when an operation was queued, started, moved, paused or resumed.
+     */
+    void queueChanged();
 
 public Q_SLOTS:
     void startOperation(FileOperation *operation, bool addToHistory = true);
@@ -60,6 +84,65 @@ public Q_SLOTS:
     void onFilesDeleted(const QStringList &uris);
 
     QVariant handleError(const QString &srcUri, const QString &destUri, const GErrorWrapperPtr &err, bool critical);
+    QVariant handleConflicts(const QList<Peony::FileOperationConflict> &conflicts);
+
+    /*!
+     * \brief moveQueuedOperation
+     * \param operation, a queued operation.
+     * \param index, the new position in queue.
+     * <br>
+     * The order only matters between the operations which share a device.
+     * </br>
+     */
+    void moveQueuedOperation(FileOperation *operation, int index);
+    /*!
+     * \brief setOperationPaused
+     * \param operation, a queued operation.
+     * \param paused
+     * <br>
+     * A paused operation stays in queue and does not block the operations
+     * behind it. It is scheduled again when it was resumed.
+     * </br>
+     * \note
+     * The operation which has been started can not be paused.
+     */
+    void setOperationPaused(FileOperation *operation, bool paused = true);
+    /*!
+     * \brief cancelQueuedOperation
+     * \param operation, a queued operation.
+     * <br>
+     * Remove the operation from queue and destroy it, it will never be executed.
+     * </br>
+     */
+    void cancelQueuedOperation(FileOperation *operation);
+
+protected:
+    /*!
+     * \brief scheduleOperations
+     * <br>
+     * Start the queued operations whose devices are not occupied by a running
+     * operation or an earlier queued operation.
+     * </br>
+     */
+    void scheduleOperations();
+    void executeOperation(FileOperation *operation, const QStringList &devices);
+    /*!
+     * \brief createWizard
+     * \return the progress wizard of operation, it is created when the operation
+     * queued, so that a waiting operation could be shown and controlled.
+     */
+    FileOperationProgressWizard *createWizard(FileOperation *operation);
+    /*!
+     * \brief showQueuedOperations
+     * <br>
+     * Show the wizards of the queued operations which are still waiting.
+     * </br>
+     */
+    void showQueuedOperations();
+
+protected Q_SLOTS:
+    void onOperationJobFinished(int jobId);
+    void onOperationDevicesResolved(int resolveId, const QStringList &devices);
 
 private:
     explicit FileOperationManager(QObject *parent = nullptr);
@@ -70,6 +153,41 @@ private:
 
     QThreadPool *m_thread_pool;
     bool m_is_current_operation_errored = false;
+
+    QList<FileOperation*> m_queued_operations;
+    QSet<FileOperation*> m_paused_operations;
+    /*!
+     * \brief m_operation_devices
+     * \details
+     * The devices of queued operations, they are resolved in m_device_pool after the
+     * operation queued. An operation is not scheduled until its devices resolved,
+     * but it does not hold up the operations resolved after it.
+     */
+    QHash<FileOperation*, QStringList> m_operation_devices;
+    QThreadPool *m_device_pool;
+    /*!
+     * \brief m_operation_wizards
+     * \details
+     * The wizards of queued operations, a wizard is handed to its operation
+     * when the operation is executed.
+     */
+    QHash<FileOperation*, FileOperationProgressWizard*> m_operation_wizards;
+    /*!
+     * \brief m_resolving_operations
+     * \details
+     * The queued operations whose devices are being resolved, keyed by the resolve id.
+     */
+    QHash<int, FileOperation*> m_resolving_operations;
+    int m_last_resolve_id = 0;
+    /*!
+     * \brief m_running_devices
+     * \details
+     * The devices occupied by the running operations, keyed by the job id.
+     * The id is used rather than the operation, because the operation
+     * has been destroyed when its job finished.
+     */
+    QHash<int, QStringList> m_running_devices;
+    int m_last_job_id = 0;
 };
 
 class FileOperationInfo : public QObject
@@ -12,10 +12,11 @@
 #include <QMessageBox>
 
 #include <QSystemTrayIcon>
+#include <QTimer>
 
-#include <gio/gio.h>
+#include "file-operation-progress.h"
 
-#include <QDebug>
+#include <gio/gio.h>
 
 using namespace Peony;
 
@@ -26,8 +27,24 @@ FileOperationProgressWizard::FileOperationProgressWizard(QWidget *parent) : QWiz
     QList<WizardButton> layout;
     layout<<Stretch<<CustomButton1;
     setButtonText(CustomButton1, tr("&Cancel"));
-    connect(this, &QWizard::customButtonClicked, [=](){
-        this->cancelled();
+    setButtonText(CustomButton2, tr("&Pause"));
+    setButtonText(CustomButton3, tr("Start &First"));
+    connect(this, &QWizard::customButtonClicked, [=](int which){
+        switch (which) {
+        case CustomButton1:
+            Q_EMIT this->cancelled();
+            break;
+        case CustomButton2:
+            m_paused = !m_paused;
+            updateQueuedPage();
+            Q_EMIT this->pauseRequested(m_paused);
+            break;
+        case CustomButton3:
+            Q_EMIT this->moveToFrontRequested();
+            break;
+        default:
+            break;
+        }
     });
     setButtonLayout(layout);
 
@@ -53,6 +70,11 @@ FileOperationProgressWizard::FileOperationProgressWizard(QWidget *parent) : QWiz
         this->show();
         m_tray_icon->hide();
     });
+
+    //20 fps is smooth enough for a progress, and it does not depend on files count.
+    m_sample_timer = new QTimer(this);
+    m_sample_timer->setInterval(50);
+    connect(m_sample_timer, &QTimer::timeout, this, &FileOperationProgressWizard::updateProgress);
 }
 
 FileOperationProgressWizard::~FileOperationProgressWizard()
@@ -60,6 +82,63 @@ FileOperationProgressWizard::~FileOperationProgressWizard()
 
 }
 
+void FileOperationProgressWizard::setProgress(std::shared_ptr<FileOperationProgress> progress)
+{
+    m_progress = progress;
+    if (m_progress) {
+        m_sample_timer->start();
+    } else {
+        m_sample_timer->stop();
+    }
+}
+
+void FileOperationProgressWizard::updateProgress()
+{
+    if (!m_progress)
+        return;
+
+    if (currentPage() == m_first_page) {
+        int count = m_progress->foundCount();
+        if (count == m_total_count)
+            return;
+        m_total_count = count;
+        m_total_size = m_progress->foundSize();
+        QString uri, destUri;
+        m_progress->currentFile(&uri, &destUri);
+        updatePreparePage(uri);
+    } else if (currentPage() == m_second_page) {
+        //the total might be still refining in a pipelined operation.
+        int count = m_progress->progressedCount();
+        int totalCount = m_progress->foundCount();
+        if (count == m_current_count && totalCount == m_total_count)
+            return;
+        m_current_count = count;
+        m_current_size = m_progress->progressedSize();
+        m_total_count = totalCount;
+        m_total_size = m_progress->foundSize();
+        QString uri, destUri;
+        m_progress->currentFile(&uri, &destUri);
+        updateProgressPage(uri, destUri);
+    } else if (currentPage() == m_third_page) {
+        //some operations start clearing before the files are all counted.
+        int count = m_progress->clearedCount();
+        int totalCount = m_progress->foundCount();
+        if (count == m_third_page->m_file_deleted_count && totalCount == m_total_count)
+            return;
+        m_third_page->m_file_deleted_count = count;
+        m_total_count = totalCount;
+        QString uri, destUri;
+        m_progress->currentFile(&uri, &destUri);
+        updateAfterProgressPage(uri);
+    } else if (currentPage() == m_last_page) {
+        int count = m_progress->rollbackedCount();
+        if (count == m_last_page->m_current_count)
+            return;
+        m_last_page->m_current_count = count;
+        updateRollbackPage();
+    }
+}
+
 void FileOperationProgressWizard::closeEvent(QCloseEvent *e)
 {
     //NOTE: the wizard will destroy when file operation finished.
@@ -77,6 +156,40 @@ void FileOperationProgressWizard::closeEvent(QCloseEvent *e)
     QWizard::closeEvent(e);
 }
 
+void FileOperationProgressWizard::setQueued(bool queued)
+{
+    if (m_queued == queued)
+        return;
+    m_queued = queued;
+    m_paused = false;
+
+    QList<WizardButton> layout;
+    layout<<Stretch;
+    if (queued)
+        layout<<CustomButton3<<CustomButton2;
+    layout<<CustomButton1;
+    setButtonLayout(layout);
+
+    restart();
+    if (queued) {
+        updateQueuedPage();
+        show();
+    } else {
+        m_first_page->setTitle(tr("Preparing..."));
+        m_first_page->m_src_line->clear();
+        m_first_page->m_state_line->clear();
+        hide();
+    }
+}
+
+void FileOperationProgressWizard::updateQueuedPage()
+{
+    setButtonText(CustomButton2, m_paused? tr("&Resume"): tr("&Pause"));
+    m_first_page->setTitle(m_paused? tr("Paused"): tr("Waiting..."));
+    m_first_page->m_src_line->setText(tr("Waiting for the other operations on the same device."));
+    m_first_page->m_state_line->setText(m_paused? tr("This operation will not start until it is resumed."): QString());
+}
+
 void FileOperationProgressWizard::switchToPreparedPage()
 {
     restart();
@@ -89,10 +202,13 @@ void FileOperationProgressWizard::switchToPreparedPage()
 
 void FileOperationProgressWizard::onElementFoundOne(const QString &uri, const qint64 &size)
 {
-    qDebug()<<"onElementFound"<<uri<<size;
     m_total_count++;
     m_total_size += size;
+    updatePreparePage(uri);
+}
 
+void FileOperationProgressWizard::updatePreparePage(const QString &uri)
+{
     char *format_size = g_format_size (quint64(m_total_size));
 
     m_first_page->m_src_line->setText(uri);
@@ -117,10 +233,13 @@ void FileOperationProgressWizard::switchToProgressPage()
 
 void FileOperationProgressWizard::onFileOperationProgressedOne(const QString &uri, const QString &destUri, const qint64 &size)
 {
-    qDebug()<<"onFileOperationFinishedOne"<<uri<<size;
     m_current_count++;
     m_current_size += size;
+    updateProgressPage(uri, destUri);
+}
 
+void FileOperationProgressWizard::updateProgressPage(const QString &uri, const QString &destUri)
+{
     char *current_format_size = g_format_size (quint64(m_current_size));
     char *total_format_size = g_format_size(quint64(m_total_size));
     m_second_page->m_state_line->setText(tr("%1 done, %2 total, %3 of %4.").
@@ -131,8 +250,11 @@ void FileOperationProgressWizard::onFileOperationProgressedOne(const QString &ur
     g_free(total_format_size);
     m_second_page->m_src_line->setText(uri);
     m_second_page->m_dest_line->setText(destUri);
-    double test = (m_current_size*1.0/m_total_size)*100;
-    m_second_page->m_progress_bar->setValue(int(test));
+    //the total size might be still refining in a pipelined operation.
+    if (m_total_size > 0) {
+        double test = (m_current_size*1.0/m_total_size)*100;
+        m_second_page->m_progress_bar->setValue(int(test));
+    }
 }
 
 void FileOperationProgressWizard::onFileOperationProgressedAll()
@@ -153,12 +275,17 @@ void FileOperationProgressWizard::switchToAfterProgressPage()
 void FileOperationProgressWizard::onElementClearOne(const QString &uri)
 {
     m_third_page->m_file_deleted_count++;
+    updateAfterProgressPage(uri);
+}
+
+void FileOperationProgressWizard::updateAfterProgressPage(const QString &uri)
+{
     m_third_page->m_src_line->setText(tr("clearing: %1, %2 of %3").arg(uri).
                                       arg(m_third_page->m_file_deleted_count).
                                       arg(m_total_count));
 
-    m_third_page->m_progress_bar->setValue(int(m_third_page->m_file_deleted_count*100.0)/m_total_count);
-
+    if (m_total_count > 0)
+        m_third_page->m_progress_bar->setValue(int(m_third_page->m_file_deleted_count*100.0/m_total_count));
 }
 
 void FileOperationProgressWizard::switchToRollbackPage()
@@ -178,8 +305,14 @@ void FileOperationProgressWizard::onFileRollbacked(const QString &destUri, const
     Q_UNUSED(destUri);
     Q_UNUSED(srcUri);
     m_last_page->m_current_count++;
+    updateRollbackPage();
+}
+
+void FileOperationProgressWizard::updateRollbackPage()
+{
     //use wizard's m_current_count as total count of files need rollback.
-    m_last_page->m_progress_bar->setValue(int(m_last_page->m_current_count*100.0/m_current_count));
+    if (m_current_count > 0)
+        m_last_page->m_progress_bar->setValue(int(m_last_page->m_current_count*100.0/m_current_count));
 }
 
 //FileOperationPreparePage
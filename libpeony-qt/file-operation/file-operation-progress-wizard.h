@@ -2,6 +2,7 @@
 #define FILEOPERATIONPROGRESSWIZARD_H
 
 #include <QWizard>
+#include <memory>
 
 #include "peony-core_global.h"
 
@@ -11,9 +12,12 @@ class QProgressBar;
 class QFormLayout;
 class QGridLayout;
 class QSystemTrayIcon;
+class QTimer;
 
 namespace Peony {
 
+class FileOperationProgress;
+
 class FileOperationPreparePage;
 class FileOperationProgressPage;
 class FileOperationAfterProgressPage;
@@ -27,6 +31,16 @@ class FileOperationRollbackPage;
  * The preparing page is used to count the source files need to be handled.
  * And the progress page is used to show the current progress of the operation.
  * </br>
+ * <br>
+ * The wizard could sample the progress of an operation at a fixed rate with
+ * setProgress(), rather than updating itself for every file. This is the way
+ * FileOperationManager uses it.
+ * </br>
+ * <br>
+ * An operation which waits for the others on the same device is shown in the
+ * queued state, it could be paused, resumed, moved to the front of queue or
+ * cancelled before it starts.
+ * </br>
  * \note
  * This is the common interface of all kinds of file operation. If you want to
  * implement a special interface for one kind operation. you can dervied the class
@@ -48,10 +62,33 @@ public:
     explicit FileOperationProgressWizard(QWidget *parent = nullptr);
     ~FileOperationProgressWizard() override;
 
+    /*!
+     * \brief setProgress
+     * \param progress, the progress channel of an operation.
+     * <br>
+     * The wizard will sample the progress with a timer while it is visible.
+     * The per-file slots should not be connected in this case.
+     * </br>
+     * \see FileOperation::progress().
+     */
+    void setProgress(std::shared_ptr<FileOperationProgress> progress);
+
 Q_SIGNALS:
     void cancelled();
+    void pauseRequested(bool paused);
+    void moveToFrontRequested();
 
 public Q_SLOTS:
+    /*!
+     * \brief setQueued
+     * \param queued
+     * <br>
+     * Show the wizard in the queued state, or leave it and hide the wizard, the
+     * operation will request showing the wizard when it starts.
+     * </br>
+     */
+    void setQueued(bool queued = true);
+
     virtual void switchToPreparedPage();
     virtual void onElementFoundOne(const QString &uri, const qint64 &size);
     virtual void onElementFoundAll();
@@ -66,11 +103,25 @@ public Q_SLOTS:
     virtual void switchToRollbackPage();
     virtual void onFileRollbacked(const QString &destUri, const QString &srcUri);
 
+protected Q_SLOTS:
+    /*!
+     * \brief updateProgress
+     * <br>
+     * Update the current page with the latest sampled progress.
+     * </br>
+     */
+    void updateProgress();
+
 protected:
     void closeEvent(QCloseEvent *e) override;
+    void updatePreparePage(const QString &uri);
+    void updateProgressPage(const QString &uri, const QString &destUri);
+    void updateAfterProgressPage(const QString &uri);
+    void updateRollbackPage();
+    void updateQueuedPage();
 
     qint64 m_total_size = 0;
-    int m_current_size = 0;
+    qint64 m_current_size = 0;
     int m_total_count = 0;
     int m_current_count = 0;
 
@@ -81,6 +132,12 @@ protected:
 
 private:
     QSystemTrayIcon *m_tray_icon = nullptr;
+
+    std::shared_ptr<FileOperationProgress> m_progress = nullptr;
+    QTimer *m_sample_timer = nullptr;
+
+    bool m_queued = false;
+    bool m_paused = false;
 };
 
 class PEONYCORESHARED_EXPORT FileOperationPreparePage : public QWizardPage
@@ -0,0 +1,67 @@
+#include "file-operation-progress.h"
+
+using namespace Peony;
+
+FileOperationProgress::FileOperationProgress()
+{
+
+}
+
+FileOperationProgress::~FileOperationProgress()
+{
+
+}
+
+void FileOperationProgress::addFound(const QString &uri, qint64 size, int count)
+{
+    m_found_count.fetchAndAddRelaxed(count);
+    m_found_size.fetchAndAddRelaxed(size);
+
+    QMutexLocker locker(&m_mutex);
+    m_current_uri = uri;
+}
+
+void FileOperationProgress::addProgressed(const QString &uri, const QString &destUri, qint64 size, int count)
+{
+    m_progressed_count.fetchAndAddRelaxed(count);
+    m_progressed_size.fetchAndAddRelaxed(size);
+
+    QMutexLocker locker(&m_mutex);
+    m_current_uri = uri;
+    m_current_dest_uri = destUri;
+    m_current_offset = size;
+    m_current_size = size;
+}
+
+void FileOperationProgress::addCleared(const QString &uri, int count)
+{
+    m_cleared_count.fetchAndAddRelaxed(count);
+
+    QMutexLocker locker(&m_mutex);
+    m_current_uri = uri;
+}
+
+void FileOperationProgress::addRollbacked()
+{
+    m_rollbacked_count.fetchAndAddRelaxed(1);
+}
+
+void FileOperationProgress::setCurrentFile(const QString &uri, const QString &destUri, qint64 offset, qint64 size)
+{
+    QMutexLocker locker(&m_mutex);
+    m_current_uri = uri;
+    m_current_dest_uri = destUri;
+    m_current_offset = offset;
+    m_current_size = size;
+}
+
+void FileOperationProgress::currentFile(QString *uri, QString *destUri, qint64 *offset, qint64 *size)
+{
+    QMutexLocker locker(&m_mutex);
+    *uri = m_current_uri;
+    *destUri = m_current_dest_uri;
+    if (offset)
+        *offset = m_current_offset;
+    if (size)
+        *size = m_current_size;
+}
@@ -0,0 +1,78 @@
+#ifndef FILEOPERATIONPROGRESS_H
+#define FILEOPERATIONPROGRESS_H
+
+#include "peony-core_global.h"
+
+#include <QAtomicInteger>
+#include <QMutex>
+#include <QString>
+
+namespace Peony {
+
+/*!
+ * \brief The FileOperationProgress class
+ * <br>
+ * FileOperationProgress is the progress channel between a running file operation
+ * and its ui. The operation thread only updates the counters and the current file,
+ * it never talks to the ui thread. The ui samples the progress at a fixed rate,
+ * so the cost of progress reporting does not grow with the count of files.
+ * </br>
+ * \note
+ * The counters are updated from the operation's own signals with direct
+ * connections, so every operation gets the progress without any change.
+ * \see FileOperation::progress(), FileOperationProgressWizard::setProgress().
+ */
+class PEONYCORESHARED_EXPORT FileOperationProgress
+{
+public:
+    FileOperationProgress();
+    ~FileOperationProgress();
+
+    /*!
+     * \brief addFound
+     * \param count, the count of files found, an engine might report them in batch.
+     */
+    void addFound(const QString &uri, qint64 size, int count = 1);
+    void addProgressed(const QString &uri, const QString &destUri, qint64 size, int count = 1);
+    void addCleared(const QString &uri, int count = 1);
+    void addRollbacked();
+    /*!
+     * \brief setCurrentFile
+     * \details
+     * Record the transfer state of a file which is being handled, it might be
+     * called for every progress callback of gio.
+     */
+    void setCurrentFile(const QString &uri, const QString &destUri, qint64 offset, qint64 size);
+
+    int foundCount() {return m_found_count.load();}
+    qint64 foundSize() {return m_found_size.load();}
+    int progressedCount() {return m_progressed_count.load();}
+    qint64 progressedSize() {return m_progressed_size.load();}
+    int clearedCount() {return m_cleared_count.load();}
+    int rollbackedCount() {return m_rollbacked_count.load();}
+
+    /*!
+     * \brief currentFile
+     * \details
+     * Get the file which was handled at last, and the transfer state of it.
+     */
+    void currentFile(QString *uri, QString *destUri, qint64 *offset = nullptr, qint64 *size = nullptr);
+
+private:
+    QAtomicInt m_found_count = 0;
+    QAtomicInteger<qint64> m_found_size = 0;
+    QAtomicInt m_progressed_count = 0;
+    QAtomicInteger<qint64> m_progressed_size = 0;
+    QAtomicInt m_cleared_count = 0;
+    QAtomicInt m_rollbacked_count = 0;
+
+    QMutex m_mutex;
+    QString m_current_uri = nullptr;
+    QString m_current_dest_uri = nullptr;
+    qint64 m_current_offset = 0;
+    qint64 m_current_size = 0;
+};
+
+}
+
+#endif // FILEOPERATIONPROGRESS_H
@@ -1,4 +1,8 @@
 #include "file-operation.h"
+#include "file-operation-manager.h"
+#include "file-operation-progress.h"
+
+#include <QMetaMethod>
 
 using namespace Peony;
 
@@ -6,6 +10,21 @@ FileOperation::FileOperation(QObject *parent) : QObject (parent)
 {
     m_cancellable_wrapper = wrapGCancellable(g_cancellable_new());
     setAutoDelete(true);
+
+    //the signals are sent in operation thread, count them there.
+    m_progress = std::make_shared<FileOperationProgress>();
+    connect(this, &FileOperation::operationPreparedOne, this, [=](const QString &srcUri, const qint64 &size){
+        m_progress->addFound(srcUri, size);
+    }, Qt::DirectConnection);
+    connect(this, &FileOperation::operationProgressedOne, this, [=](const QString &srcUri, const QString &destUri, const qint64 &size){
+        m_progress->addProgressed(srcUri, destUri, size);
+    }, Qt::DirectConnection);
+    connect(this, &FileOperation::operationAfterProgressedOne, this, [=](const QString &srcUri){
+        m_progress->addCleared(srcUri);
+    }, Qt::DirectConnection);
+    connect(this, &FileOperation::operationRollbackedOne, this, [=](){
+        m_progress->addRollbacked();
+    }, Qt::DirectConnection);
 }
 
 FileOperation::~FileOperation()
@@ -18,8 +37,49 @@ void FileOperation::run()
 
 }
 
+void FileOperation::reportFileProgress(const QString &srcUri, const QString &destUri,
+                                       const qint64 &current_file_offset, const qint64 &current_file_size)
+{
+    m_progress->setCurrentFile(srcUri, destUri, current_file_offset, current_file_size);
+
+    static const QMetaMethod signal = QMetaMethod::fromSignal(&FileOperation::FileProgressCallback);
+    if (isSignalConnected(signal))
+        Q_EMIT FileProgressCallback(srcUri, destUri, current_file_offset, current_file_size);
+}
+
 void FileOperation::cancel()
 {
     g_cancellable_cancel(m_cancellable_wrapper.get()->get());
-    m_is_cancelled = true;
+    m_is_cancelled.store(1);
+}
+
+bool FileOperation::isPipelinedInto(const QStringList &sourceUris, const QString &destDirUri)
+{
+    if (!isPipelined())
+        return false;
+
+    //the tree must be snapshotted before copying into itself.
+    GFile *dest_dir = g_file_new_for_uri(destDirUri.toUtf8().constData());
+    bool inside = false;
+    for (auto uri : sourceUris) {
+        GFile *source = g_file_new_for_uri(uri.toUtf8().constData());
+        inside = g_file_equal(source, dest_dir) || g_file_has_prefix(dest_dir, source);
+        g_object_unref(source);
+        if (inside)
+            break;
+    }
+    g_object_unref(dest_dir);
+    return !inside;
+}
+
+QStringList FileOperation::involvedUris()
+{
+    QStringList uris;
+    auto info = getOperationInfo();
+    if (info) {
+        uris<<info->sources();
+        if (!info->target().isEmpty())
+            uris<<info->target();
+    }
+    return uris;
 }
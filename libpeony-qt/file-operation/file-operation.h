@@ -8,13 +8,30 @@
 #include "gobject-template.h"
 
 #include <QMetaType>
+#include <QAtomicInt>
 #include <QHash>
+#include <QStringList>
 
 #include "peony-core_global.h"
 
 namespace Peony {
 
 class FileOperationInfo;
+class FileOperationProgress;
+
+/*!
+ * \brief The FileOperationConflict struct
+ * <br>
+ * A failed item which was parked by an operation in deferred-conflict mode.
+ * </br>
+ * \see FileOperation::setConflictsDeferred().
+ */
+struct FileOperationConflict {
+    QString srcUri;
+    QString destDirUri;
+    GErrorWrapperPtr err;
+};
+
 /*!
  * \brief The FileOperation class
  * <br>
@@ -47,9 +64,17 @@ public:
         BackupAll,
         Retry,
         Cancel,
+        OverWriteNewer,//overwrite if the source is newer than target, otherwise ignore.
         Other
     };
 
+    /*!
+     * \brief ConflictRules
+     * \details
+     * The responses for the deferred conflicts, keyed by the error code.
+     */
+    typedef QHash<int, ResponseType> ConflictRules;
+
     explicit FileOperation(QObject *parent = nullptr);
     ~FileOperation();
     virtual void run();
@@ -64,6 +89,7 @@ public:
      * This is a virtual function, some derived operation class should override
      * this function.
      * The FileOperation instance will destroy itself when it finished, but its info might not.
+     * An operation might only know its info after run(), such as FileUntrashOperation.
      * The FileOperationInfo is a part of peony-qt's undo/redo stack(s). FileOperationManager
      * will manage the stack(s) made up of these info.
      */
@@ -83,7 +109,75 @@ public:
     void setShouldReversible(bool reversible = true) {m_reversible = reversible;}
     virtual bool reversible() {return m_reversible;}
 
-    bool isCancelled() {return m_is_cancelled;}
+    /*!
+     * \brief setPipelined
+     * \param pipelined
+     * \details
+     * If an operation is pipelined, it starts handling the files as soon as they
+     * are found, rather than waiting for the whole tree prepared. The total count
+     * and size sent by operationPreparedOne() keep refining while the operation
+     * is progressing, and operationPrepared() is sent at the beginning.
+     * \note
+     * Only the operations which enumerate the source trees support this mode, such
+     * as copy, delete and fallback move. It is disabled by default. A copy or move
+     * whose target is inside a source is never pipelined, the scanner would walk into
+     * the copied folders.
+     * \see FileNodeScanner.
+     */
+    void setPipelined(bool pipelined = true) {m_pipelined = pipelined;}
+    bool isPipelined() {return m_pipelined;}
+
+    bool isCancelled() {return m_is_cancelled.load();}
+
+    /*!
+     * \brief setConflictsDeferred
+     * \param deferred
+     * \details
+     * In deferred-conflict mode, an item which gets into error does not block the
+     * operation by the error handler. It is parked in a conflict queue and the
+     * operation keeps processing the other items. The parked items are resolved in
+     * bulk by conflictsDeferred() at the end, and then they are handled again.
+     * \note
+     * This only works with the operations which support it, such as copy. Others
+     * always handle the error when it happened.
+     */
+    void setConflictsDeferred(bool deferred = true) {m_conflicts_deferred = deferred;}
+    bool isConflictsDeferred() {return m_conflicts_deferred;}
+
+    /*!
+     * \brief setJournaled
+     * \param journaled
+     * \details
+     * In journaled mode, the large files are copied with a transfer journal. A file
+     * whose transfer broke is not cleared when rollbacking, and copying it again
+     * resumes from where it broke, even in another operation.
+     * \note
+     * This only works with copy and fallback move. It is disabled by default.
+     * \see FileCopyEngine::copyResumable(), FileTransferJournal.
+     */
+    void setJournaled(bool journaled = true) {m_journaled = journaled;}
+    bool isJournaled() {return m_journaled;}
+
+    /*!
+     * \brief involvedUris
+     * \return the uris of sources and target of this operation.
+     * \details
+     * FileOperationManager uses these uris to find out the devices which the operation
+     * reads and writes. The default implementation returns the sources and target of
+     * the operation info, a derived class without operation info should override it.
+     */
+    virtual QStringList involvedUris();
+
+    /*!
+     * \brief progress
+     * \return the progress channel of this operation.
+     * \details
+     * The progress is accumulated from the signals of operation in the operation thread.
+     * A ui should sample it with a timer rather than connecting the per-file signals,
+     * which are emitted for every file.
+     * \see FileOperationProgress.
+     */
+    std::shared_ptr<FileOperationProgress> progress() {return m_progress;}
 
 Q_SIGNALS:
     /*!
@@ -123,6 +217,16 @@ Q_SIGNALS:
      * derived class in main thread.
      */
     QVariant errored(const QString &srcUri, const QString &destUri, const Peony::GErrorWrapperPtr &err, bool isCritical = false);
+    /*!
+     * \brief conflictsDeferred
+     * \param conflicts, the items parked in deferred-conflict mode.
+     * \return \retval ConflictRules for resolving the conflicts. The conflicts whose
+     * error code is not in the rules will be handled one by one by errored().
+     * A Cancel rule cancels the operation.
+     * \note
+     * Like errored(), it must be connected with Qt::BlockingQueuedConnection.
+     */
+    QVariant conflictsDeferred(const QList<Peony::FileOperationConflict> &conflicts);
 
     void FileProgressCallback(const QString &srcUri, const QString &destUri,
                               const qint64 &current_file_offset, const qint64 &current_file_size);
@@ -253,16 +357,44 @@ public Q_SLOTS:
 
 protected:
     GCancellableWrapperPtr getCancellable(){return m_cancellable_wrapper;}
+    /*!
+     * \brief reportFileProgress
+     * \details
+     * This should be called in the progress callback of gio. It records the transfer
+     * state into progress(), and only sends FileProgressCallback() if it is connected.
+     */
+    void reportFileProgress(const QString &srcUri, const QString &destUri,
+                            const qint64 &current_file_offset, const qint64 &current_file_size);
+    /*!
+     * \brief isPipelinedInto
+     * \param sourceUris
+     * \param destDirUri
+     * \return true if the operation is pipelined and the dest directory is not one
+     * of the sources or inside them.
+     * \see setPipelined().
+     */
+    bool isPipelinedInto(const QStringList &sourceUris, const QString &destDirUri);
 
 private:
     GCancellableWrapperPtr m_cancellable_wrapper = nullptr;
-    bool m_is_cancelled = false;
+    std::shared_ptr<FileOperationProgress> m_progress = nullptr;
+    /*!
+     * \brief m_is_cancelled
+     * \details
+     * It is set in ui thread and read by the jobs in other threads.
+     */
+    QAtomicInt m_is_cancelled = 0;
     bool m_reversible = false;
     bool m_has_error = false;
+    bool m_pipelined = false;
+    bool m_conflicts_deferred = false;
+    bool m_journaled = false;
 };
 
 }
 
 Q_DECLARE_METATYPE(Peony::FileOperation::ResponseType)
+Q_DECLARE_METATYPE(Peony::FileOperation::ConflictRules)
+Q_DECLARE_METATYPE(Peony::FileOperationConflict)
 
 #endif // FILEOPERATION_H
@@ -8,11 +8,21 @@ HEADERS += \
     $$PWD/file-operation.h \
     $$PWD/file-move-operation.h \
     $$PWD/file-node.h \
+    $$PWD/file-node-arena.h \
     $$PWD/file-node-reporter.h \
+    $$PWD/file-node-scanner.h \
+    $$PWD/file-operation-progress.h \
     $$PWD/file-operation-progress-wizard.h \
     $$PWD/file-operation-error-handler.h \
     $$PWD/file-operation-error-dialog.h \
+    $$PWD/file-operation-conflict-dialog.h \
     $$PWD/file-copy-operation.h \
+    $$PWD/file-copy-engine.h \
+    $$PWD/file-checksum.h \
+    $$PWD/file-transfer-journal.h \
+    $$PWD/file-delete-engine.h \
+    $$PWD/file-trash-engine.h \
+    $$PWD/trash-index.h \
     $$PWD/file-operation-manager.h \
     $$PWD/file-delete-operation.h \
     $$PWD/file-link-operation.h \
@@ -24,10 +34,20 @@ SOURCES += \
     $$PWD/file-operation.cpp \
     $$PWD/file-move-operation.cpp \
     $$PWD/file-node.cpp \
+    $$PWD/file-node-arena.cpp \
     $$PWD/file-node-reporter.cpp \
+    $$PWD/file-node-scanner.cpp \
+    $$PWD/file-operation-progress.cpp \
     $$PWD/file-operation-progress-wizard.cpp \
     $$PWD/file-operation-error-dialog.cpp \
+    $$PWD/file-operation-conflict-dialog.cpp \
     $$PWD/file-copy-operation.cpp \
+    $$PWD/file-copy-engine.cpp \
+    $$PWD/file-checksum.cpp \
+    $$PWD/file-transfer-journal.cpp \
+    $$PWD/file-delete-engine.cpp \
+    $$PWD/file-trash-engine.cpp \
+    $$PWD/trash-index.cpp \
     $$PWD/file-operation-manager.cpp \
     $$PWD/file-delete-operation.cpp \
     $$PWD/file-link-operation.cpp \
@@ -0,0 +1,164 @@
+#include "file-transfer-journal.h"
+
+#include <QCryptographicHash>
+#include <QFile>
+#include <QDir>
+#include <QFileInfo>
+#include <QTextStream>
+
+#include <glib.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+#define JOURNAL_MAGIC "peony-transfer-journal 1"
+
+using namespace Peony;
+
+FileTransferJournal::FileTransferJournal(const QString &srcUri, const QString &destUri)
+{
+    m_src_uri = srcUri;
+    m_dest_uri = destUri;
+    m_path = journalPath(srcUri, destUri);
+}
+
+FileTransferJournal::~FileTransferJournal()
+{
+    if (m_fd >= 0)
+        close(m_fd);
+}
+
+QString FileTransferJournal::journalPath(const QString &srcUri, const QString &destUri)
+{
+    QByteArray key = QCryptographicHash::hash((srcUri + "\n" + destUri).toUtf8(), QCryptographicHash::Sha1).toHex();
+    return QString("%1/peony-qt/transfer-journal/%2.journal").arg(g_get_user_cache_dir()).arg(QString(key));
+}
+
+bool FileTransferJournal::exists(const QString &srcUri, const QString &destUri)
+{
+    return QFile::exists(journalPath(srcUri, destUri));
+}
+
+QByteArray FileTransferJournal::chunkChecksum(const char *data, qint64 length)
+{
+    return QCryptographicHash::hash(QByteArray::fromRawData(data, int(length)), QCryptographicHash::Md5).toHex();
+}
+
+bool FileTransferJournal::load(qint64 size, qint64 mtime)
+{
+    m_chunks.clear();
+
+    QFile file(m_path);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    //the header must match this transfer, or it is stale.
+    QTextStream stream(&file);
+    QString expectedHeader = QString("%1\nsource %2\ndest %3\nsize %4\nmtime %5")
+            .arg(JOURNAL_MAGIC).arg(m_src_uri).arg(m_dest_uri).arg(size).arg(mtime);
+    QStringList header;
+    for (int i = 0; i < 5 && !stream.atEnd(); i++) {
+        header<<stream.readLine();
+    }
+    if (header.join("\n") != expectedHeader)
+        return false;
+
+    while (!stream.atEnd()) {
+        //chunk <offset> <length> <checksum>, a torn line at the end is ignored.
+        QStringList fields = stream.readLine().split(' ');
+        if (fields.count() != 4 || fields.at(0) != "chunk")
+            continue;
+        bool offsetOk = false;
+        bool lengthOk = false;
+        qint64 offset = fields.at(1).toLongLong(&offsetOk);
+        qint64 length = fields.at(2).toLongLong(&lengthOk);
+        if (!offsetOk || !lengthOk || length <= 0)
+            continue;
+        m_chunks.insert(offset, qMakePair(length, fields.at(3).toLatin1()));
+    }
+    return true;
+}
+
+qint64 FileTransferJournal::resumeOffset(int dest_fd, qint64 size, qint64 mtime)
+{
+    if (!load(size, mtime))
+        return 0;
+
+    //the chunks must be contiguous from the beginning.
+    QList<qint64> offsets;
+    qint64 end = 0;
+    while (m_chunks.contains(end)) {
+        offsets<<end;
+        end += m_chunks.value(end).first;
+    }
+
+    struct stat dest_stat;
+    if (fstat(dest_fd, &dest_stat) != 0)
+        return 0;
+
+    //verify the chunks from the last one, the target might have lost the
+    //data which was not synced before the transfer broke.
+    QByteArray buffer;
+    while (!offsets.isEmpty()) {
+        qint64 offset = offsets.last();
+        auto chunk = m_chunks.value(offset);
+        if (offset + chunk.first <= dest_stat.st_size) {
+            buffer.resize(int(chunk.first));
+            qint64 read = 0;
+            while (read < chunk.first) {
+                ssize_t ret = pread(dest_fd, buffer.data() + read, size_t(chunk.first - read), off_t(offset + read));
+                if (ret <= 0)
+                    break;
+                read += ret;
+            }
+            if (read == chunk.first && chunkChecksum(buffer.constData(), read) == chunk.second)
+                return offset + chunk.first;
+        }
+        m_chunks.remove(offset);
+        offsets.removeLast();
+    }
+    return 0;
+}
+
+bool FileTransferJournal::begin(qint64 size, qint64 mtime)
+{
+    m_chunks.clear();
+    QDir().mkpath(QFileInfo(m_path).path());
+
+    if (m_fd >= 0)
+        close(m_fd);
+    m_fd = open(QFile::encodeName(m_path).constData(), O_WRONLY|O_CREAT|O_TRUNC|O_CLOEXEC, 0600);
+    if (m_fd < 0)
+        return false;
+
+    QByteArray header = QString("%1\nsource %2\ndest %3\nsize %4\nmtime %5\n")
+            .arg(JOURNAL_MAGIC).arg(m_src_uri).arg(m_dest_uri).arg(size).arg(mtime).toUtf8();
+    return write(m_fd, header.constData(), size_t(header.size())) == header.size();
+}
+
+bool FileTransferJournal::commitChunk(qint64 offset, qint64 length, const QByteArray &checksum)
+{
+    if (m_fd < 0) {
+        //resuming, append to the existed journal.
+        m_fd = open(QFile::encodeName(m_path).constData(), O_WRONLY|O_APPEND|O_CLOEXEC);
+        if (m_fd < 0)
+            return false;
+    }
+
+    m_chunks.insert(offset, qMakePair(length, checksum));
+    QByteArray line = QString("chunk %1 %2 %3\n").arg(offset).arg(length).arg(QString(checksum)).toLatin1();
+    return write(m_fd, line.constData(), size_t(line.size())) == line.size();
+}
+
+void FileTransferJournal::finish()
+{
+    if (m_fd >= 0) {
+        close(m_fd);
+        m_fd = -1;
+    }
+    m_chunks.clear();
+    QFile::remove(m_path);
+}
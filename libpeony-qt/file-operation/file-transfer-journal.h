@@ -0,0 +1,100 @@
+#ifndef FILETRANSFERJOURNAL_H
+#define FILETRANSFERJOURNAL_H
+
+#include "peony-core_global.h"
+
+#include <QString>
+#include <QByteArray>
+#include <QMap>
+#include <QPair>
+
+namespace Peony {
+
+/*!
+ * \brief The FileTransferJournal class
+ * <br>
+ * FileTransferJournal records the progress of a large file transfer in a small
+ * file in the user's cache directory. Every chunk copied is written to the
+ * target and synced, then its offset, length and checksum are appended to the
+ * journal. An interrupted transfer keeps its partial target, and a later copy
+ * of the same source to the same target resumes from the last chunk whose
+ * data in target still matches the journal.
+ * </br>
+ * <br>
+ * The journal is bound to the size and modification time of source, if the
+ * source changed, the transfer starts over. It is removed once the transfer
+ * finished.
+ * </br>
+ * \see FileCopyEngine::copyResumable(), FileOperation::setJournaled().
+ */
+class PEONYCORESHARED_EXPORT FileTransferJournal
+{
+public:
+    FileTransferJournal(const QString &srcUri, const QString &destUri);
+    ~FileTransferJournal();
+
+    /*!
+     * \brief exists
+     * \return true if there is an unfinished transfer from srcUri to destUri.
+     */
+    static bool exists(const QString &srcUri, const QString &destUri);
+
+    /*!
+     * \brief chunkChecksum
+     * \return the checksum recorded for a chunk of data.
+     */
+    static QByteArray chunkChecksum(const char *data, qint64 length);
+
+    /*!
+     * \brief resumeOffset
+     * \param dest_fd, the partial target opened for reading.
+     * \param size, the size of source.
+     * \param mtime, the modification time of source.
+     * \return the offset to resume from, 0 if the transfer should start over.
+     * <br>
+     * The recorded chunks are verified against the target from the last one,
+     * the chunks which do not match are dropped.
+     * </br>
+     */
+    qint64 resumeOffset(int dest_fd, qint64 size, qint64 mtime);
+
+    /*!
+     * \brief begin
+     * \details
+     * Start a new journal for a transfer from the beginning.
+     */
+    bool begin(qint64 size, qint64 mtime);
+    /*!
+     * \brief commitChunk
+     * \details
+     * Record a chunk, the chunk data must have been synced to target.
+     */
+    bool commitChunk(qint64 offset, qint64 length, const QByteArray &checksum);
+    /*!
+     * \brief finish
+     * \details
+     * Remove the journal, the transfer is completed.
+     */
+    void finish();
+
+protected:
+    static QString journalPath(const QString &srcUri, const QString &destUri);
+    bool load(qint64 size, qint64 mtime);
+
+private:
+    QString m_src_uri;
+    QString m_dest_uri;
+    QString m_path;
+    int m_fd = -1;
+
+    /*!
+     * \brief m_chunks
+     * \details
+     * The lengths and checksums of recorded chunks keyed by their offsets.
+     */
+    QMap<qint64, QPair<qint64, QByteArray>> m_chunks;
+};
+
+}
+
+#endif // FILETRANSFERJOURNAL_H
@@ -0,0 +1,189 @@
+#include "file-trash-engine.h"
+
+#include <QHash>
+#include <QPair>
+#include <QMutex>
+#include <QDateTime>
+
+#include <gio/gunixmounts.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+using namespace Peony;
+
+//the trash directories keyed by device, an empty directory means unsupported.
+static QHash<dev_t, QPair<QByteArray, QByteArray>> trash_dirs_cache;
+static QMutex trash_dirs_mutex;
+
+static bool makeTrashDir(const QByteArray &trashDir)
+{
+    if (g_mkdir_with_parents((trashDir + "/files").constData(), 0700) != 0)
+        return false;
+    if (g_mkdir_with_parents((trashDir + "/info").constData(), 0700) != 0)
+        return false;
+    return true;
+}
+
+bool FileTrashEngine::trash(GFile *file, GCancellable *cancellable, GError **error)
+{
+    char *c_path = g_file_is_native(file)? g_file_get_path(file): nullptr;
+    if (c_path) {
+        QByteArray path = c_path;
+        g_free(c_path);
+        if (g_cancellable_set_error_if_cancelled(cancellable, error))
+            return false;
+
+        NativeResult result = nativeTrash(path, error);
+        if (result == Trashed)
+            return true;
+        if (result == Failed)
+            return false;
+    }
+
+    return g_file_trash(file, cancellable, error);
+}
+
+FileTrashEngine::NativeResult FileTrashEngine::nativeTrash(const QByteArray &path, GError **error)
+{
+    struct stat st;
+    if (lstat(path.constData(), &st) != 0)
+        return Unsupported;
+
+    QByteArray trashDir;
+    QByteArray topDir;
+    if (!findTrashDir(path, st.st_dev, &trashDir, &topDir))
+        return Unsupported;
+    //let gio refuse trashing the trash itself.
+    if (path == trashDir || path.startsWith(trashDir + "/"))
+        return Unsupported;
+
+    QByteArray originalPath = path;
+    if (!topDir.isEmpty() && path.startsWith(topDir + "/"))
+        originalPath = path.mid(topDir.length() + 1);
+    char *escaped_path = g_uri_escape_string(originalPath.constData(), "/", FALSE);
+    QByteArray info = "[Trash Info]\nPath=";
+    info += escaped_path;
+    info += "\nDeletionDate=";
+    info += QDateTime::currentDateTime().toString("yyyy-MM-ddThh:mm:ss").toUtf8();
+    info += "\n";
+    g_free(escaped_path);
+
+    //reserve the name by creating the info file exclusively.
+    char *c_basename = g_path_get_basename(path.constData());
+    QByteArray basename = c_basename;
+    g_free(c_basename);
+    QByteArray trashName;
+    QByteArray infoPath;
+    int fd = -1;
+    for (int i = 1; fd < 0; i++) {
+        trashName = i == 1? basename: basename + "." + QByteArray::number(i);
+        infoPath = trashDir + "/info/" + trashName + ".trashinfo";
+        fd = open(infoPath.constData(), O_WRONLY|O_CREAT|O_EXCL|O_CLOEXEC, 0600);
+        if (fd < 0 && (errno != EEXIST || i >= 1000)) {
+            //the trash directory might have been removed.
+            QMutexLocker locker(&trash_dirs_mutex);
+            trash_dirs_cache.remove(st.st_dev);
+            return Unsupported;
+        }
+    }
+
+    bool written = write(fd, info.constData(), size_t(info.size())) == info.size();
+    if (close(fd) != 0)
+        written = false;
+    if (!written) {
+        unlink(infoPath.constData());
+        return Unsupported;
+    }
+
+    QByteArray filesPath = trashDir + "/files/" + trashName;
+    if (rename(path.constData(), filesPath.constData()) != 0) {
+        int err_code = errno;
+        unlink(infoPath.constData());
+        if (err_code == EXDEV)
+            return Unsupported;
+
+        char *display_name = g_filename_display_name(path.constData());
+        g_set_error(error, G_IO_ERROR, g_io_error_from_errno(err_code),
+                    "Unable to trash file %s: %s", display_name, g_strerror(err_code));
+        g_free(display_name);
+        return Failed;
+    }
+
+    return Trashed;
+}
+
+bool FileTrashEngine::findTrashDir(const QByteArray &path, dev_t dev, QByteArray *trashDir, QByteArray *topDir)
+{
+    QMutexLocker locker(&trash_dirs_mutex);
+    if (trash_dirs_cache.contains(dev)) {
+        auto dirs = trash_dirs_cache.value(dev);
+        *trashDir = dirs.first;
+        *topDir = dirs.second;
+        return !trashDir->isEmpty();
+    }
+
+    QByteArray homeTrash = QByteArray(g_get_user_data_dir()) + "/Trash";
+    struct stat st;
+    if (makeTrashDir(homeTrash) && stat(homeTrash.constData(), &st) == 0 && st.st_dev == dev) {
+        trash_dirs_cache.insert(dev, qMakePair(homeTrash, QByteArray()));
+        *trashDir = homeTrash;
+        topDir->clear();
+        return true;
+    }
+
+    //find the top directory of device.
+    char *c_dir = g_path_get_dirname(path.constData());
+    QByteArray dir = c_dir;
+    g_free(c_dir);
+    if (stat(dir.constData(), &st) != 0 || st.st_dev != dev) {
+        //do not cache it, this is caused by the file rather than the device.
+        return false;
+    }
+    while (dir != "/") {
+        c_dir = g_path_get_dirname(dir.constData());
+        QByteArray parent = c_dir;
+        g_free(c_dir);
+        if (stat(parent.constData(), &st) != 0 || st.st_dev != dev)
+            break;
+        dir = parent;
+    }
+    QByteArray top = dir == "/"? QByteArray(): dir;
+
+    //like gio, do not trash on the system internal mounts, such as / or /tmp.
+    GUnixMountEntry *mount = g_unix_mount_at(dir.constData(), nullptr);
+    bool internal = !mount || g_unix_mount_is_system_internal(mount);
+    if (mount)
+        g_unix_mount_free(mount);
+    if (internal) {
+        trash_dirs_cache.insert(dev, qMakePair(QByteArray(), top));
+        trashDir->clear();
+        *topDir = top;
+        return false;
+    }
+
+    QByteArray uid = QByteArray::number(getuid());
+    QByteArray trash;
+    //$topdir/.Trash/$uid, the .Trash must be a sticky directory rather than a link.
+    QByteArray adminTrash = top + "/.Trash";
+    if (lstat(adminTrash.constData(), &st) == 0 && S_ISDIR(st.st_mode) && (st.st_mode & S_ISVTX)) {
+        if (makeTrashDir(adminTrash + "/" + uid))
+            trash = adminTrash + "/" + uid;
+    }
+    //$topdir/.Trash-$uid, it must be owned by user.
+    if (trash.isEmpty()) {
+        QByteArray userTrash = top + "/.Trash-" + uid;
+        if (makeTrashDir(userTrash) && lstat(userTrash.constData(), &st) == 0 &&
+                S_ISDIR(st.st_mode) && st.st_uid == getuid()) {
+            trash = userTrash;
+        }
+    }
+
+    trash_dirs_cache.insert(dev, qMakePair(trash, top));
+    *trashDir = trash;
+    *topDir = top;
+    return !trash.isEmpty();
+}
@@ -0,0 +1,63 @@
+#ifndef FILETRASHENGINE_H
+#define FILETRASHENGINE_H
+
+#include "peony-core_global.h"
+#include <gio/gio.h>
+#include <sys/types.h>
+
+#include <QByteArray>
+
+namespace Peony {
+
+/*!
+ * \brief The FileTrashEngine class
+ * <br>
+ * FileTrashEngine trashes a file with the same interface as g_file_trash().
+ * For local files, it writes the .trashinfo and renames the file into the
+ * trash directory of its file system directly, following the freedesktop.org
+ * trash specification. The trash directory of every device is looked up
+ * once and cached, so trashing a file costs a few syscalls. A folder is
+ * renamed as a whole, its children are never walked.
+ * </br>
+ * <br>
+ * If a file can not be trashed natively, such as a remote file or a file
+ * on a device without usable trash directory, it falls back to g_file_trash().
+ * </br>
+ * \note
+ * It is thread safe, several jobs could trash files at the same time.
+ * \see FileTrashOperation.
+ */
+class PEONYCORESHARED_EXPORT FileTrashEngine
+{
+public:
+    /*!
+     * \brief trash
+     * \return true if the file was trashed.
+     * \see g_file_trash().
+     */
+    static bool trash(GFile *file, GCancellable *cancellable, GError **error);
+
+protected:
+    enum NativeResult {
+        Trashed,
+        Failed,
+        Unsupported
+    };
+
+    static NativeResult nativeTrash(const QByteArray &path, GError **error);
+    /*!
+     * \brief findTrashDir
+     * \param path, the file to be trashed.
+     * \param dev, the device of file.
+     * \param trashDir, the trash directory for the device, it contains files and info.
+     * \param topDir, the top directory of the device if the trash is not the home trash.
+     * The original paths in trash info are relative to it.
+     * \return false if there is no usable trash directory. A device other than home's
+     * which is a system internal mount, such as a tmpfs, has no trash directory.
+     */
+    static bool findTrashDir(const QByteArray &path, dev_t dev, QByteArray *trashDir, QByteArray *topDir);
+};
+
+}
+
+#endif // FILETRASHENGINE_H
@@ -1,5 +1,46 @@
 #include "file-trash-operation.h"
 #include "file-operation-manager.h"
+#include "file-operation-progress.h"
+#include "file-trash-engine.h"
+
+#include <QThreadPool>
+#include <QThread>
+
+//the count of files trashed by a job.
+#define TRASH_BATCH_SIZE 64
+//show the wizard only when trashing so many files.
+#define TRASH_WIZARD_THRESHOLD 100
+
+namespace Peony {
+
+/*!
+ * \brief The FileTrashJob class
+ * <br>
+ * A job of trashing a batch of files in FileTrashOperation's pool.
+ * </br>
+ */
+class FileTrashJob : public QRunnable
+{
+public:
+    FileTrashJob(FileTrashOperation *operation, const QStringList &uris) {
+        m_operation = operation;
+        m_uris = uris;
+    }
+
+    void run() override {
+        for (auto uri : m_uris) {
+            if (m_operation->isCancelled())
+                break;
+            m_operation->trashFile(uri);
+        }
+    }
+
+private:
+    FileTrashOperation *m_operation = nullptr;
+    QStringList m_uris;
+};
+
+}
 
 using namespace Peony;
 
@@ -9,30 +50,56 @@ FileTrashOperation::FileTrashOperation(QStringList srcUris, QObject *parent) : F
     m_info = std::make_shared<FileOperationInfo>(srcUris, "trash:///", FileOperationInfo::Trash);
 }
 
-void FileTrashOperation::run()
+void FileTrashOperation::trashFile(const QString &uri)
 {
-    Q_EMIT operationStarted();
-    for (auto src : m_src_uris) {
-        if (isCancelled())
+    auto srcFile = wrapGFile(g_file_new_for_uri(uri.toUtf8().constData()));
+retry:
+    GError *err = nullptr;
+    FileTrashEngine::trash(srcFile.get()->get(),
+                           getCancellable().get()->get(),
+                           &err);
+    if (err) {
+        if (err->code == G_IO_ERROR_CANCELLED) {
+            g_error_free(err);
+            return;
+        }
+        QMutexLocker locker(&m_error_mutex);
+        if (isCancelled()) {
+            g_error_free(err);
+            return;
+        }
+        auto responseData = Q_EMIT errored(uri, tr("trash:///"), GErrorWrapper::wrapFrom(err), true);
+        switch (responseData.value<ResponseType>()) {
+        case Retry:
+            locker.unlock();
+            goto retry;
+        case Cancel:
+            cancel();
+            break;
+        default:
             break;
-        retry:
-        auto srcFile = wrapGFile(g_file_new_for_uri(src.toUtf8().constData()));
-        GError *err = nullptr;
-        g_file_trash(srcFile.get()->get(),
-                     getCancellable().get()->get(),
-                     &err);
-        if (err) {
-            auto responseData = Q_EMIT errored(src, tr("trash:///"), GErrorWrapper::wrapFrom(err), true);
-            switch (responseData.value<ResponseType>()) {
-            case Retry:
-                goto retry;
-            case Cancel:
-                cancel();
-                break;
-            default:
-                break;
-            }
         }
     }
+    progress()->addCleared(uri);
+}
+
+void FileTrashOperation::run()
+{
+    Q_EMIT operationStarted();
+
+    if (m_src_uris.count() >= TRASH_WIZARD_THRESHOLD)
+        Q_EMIT operationRequestShowWizard();
+    //nothing to prepare, jump to the clearing stage.
+    progress()->addFound(nullptr, 0, m_src_uris.count());
+    Q_EMIT operationPrepared();
+    Q_EMIT operationProgressed();
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(qBound(2, QThread::idealThreadCount(), 8));
+    for (int i = 0; i < m_src_uris.count(); i += TRASH_BATCH_SIZE) {
+        pool.start(new FileTrashJob(this, m_src_uris.mid(i, TRASH_BATCH_SIZE)));
+    }
+    pool.waitForDone();
+
     Q_EMIT operationFinished();
 }
@@ -4,10 +4,24 @@
 #include "peony-core_global.h"
 #include "file-operation.h"
 
+#include <QMutex>
+
 namespace Peony {
 
+class FileTrashJob;
+
+/*!
+ * \brief The FileTrashOperation class
+ * <br>
+ * The files are trashed by a pool of jobs in batches, each file is trashed by
+ * FileTrashEngine, which renames the local files into the trash of their file
+ * systems directly. The wizard is shown when a lot of files are trashed.
+ * </br>
+ * \see FileTrashEngine.
+ */
 class PEONYCORESHARED_EXPORT FileTrashOperation : public FileOperation
 {
+    friend class FileTrashJob;
     Q_OBJECT
 public:
     explicit FileTrashOperation(QStringList srcUris, QObject *parent = nullptr);
@@ -15,9 +29,26 @@ public:
     std::shared_ptr<FileOperationInfo> getOperationInfo() override {return m_info;}
     void run() override;
 
+protected:
+    /*!
+     * \brief trashFile
+     * \param uri
+     * <br>
+     * Trash a file, this is called in the trash pool's threads.
+     * </br>
+     */
+    void trashFile(const QString &uri);
+
 private:
     QStringList m_src_uris;
     std::shared_ptr<FileOperationInfo> m_info = nullptr;
+
+    /*!
+     * \brief m_error_mutex
+     * \details
+     * The errors are handled one by one.
+     */
+    QMutex m_error_mutex;
 };
 
 }
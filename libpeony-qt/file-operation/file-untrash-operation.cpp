@@ -1,35 +1,75 @@
 #include "file-untrash-operation.h"
 #include "file-utils.h"
 #include "file-operation-manager.h"
+#include "file-operation-progress.h"
+#include "trash-index.h"
+
+#include <QThreadPool>
+#include <QThread>
+#include <QFile>
+
+//the count of items restored by a job.
+#define UNTRASH_BATCH_SIZE 64
+//show the wizard only when restoring so many items.
+#define UNTRASH_WIZARD_THRESHOLD 100
+
+namespace Peony {
+
+/*!
+ * \brief The FileUntrashJob class
+ * <br>
+ * A job of restoring a batch of items in FileUntrashOperation's pool.
+ * </br>
+ */
+class FileUntrashJob : public QRunnable
+{
+public:
+    FileUntrashJob(FileUntrashOperation *operation, const QStringList &uris) {
+        m_operation = operation;
+        m_uris = uris;
+    }
+
+    void run() override {
+        for (auto uri : m_uris) {
+            if (m_operation->isCancelled())
+                break;
+            m_operation->untrashFile(uri);
+        }
+    }
+
+private:
+    FileUntrashOperation *m_operation = nullptr;
+    QStringList m_uris;
+};
+
+}
 
 using namespace Peony;
 
 FileUntrashOperation::FileUntrashOperation(QStringList uris, QObject *parent) : FileOperation (parent)
 {
     m_uris = uris;
-    //FIXME: should i put this into prepare process?
-    cacheOriginalUri();
-    QStringList oppositeSrcUris;
-    for (auto value : m_restore_hash) {
-        oppositeSrcUris<<value;
-    }
-    m_info = std::make_shared<FileOperationInfo>(oppositeSrcUris, "trash:///", FileOperationInfo::Trash);
 }
 
 void FileUntrashOperation::cacheOriginalUri()
 {
+    auto index = TrashIndex::getInstance();
     for (auto uri : m_uris) {
         if (isCancelled())
             break;
 
-        auto file = wrapGFile(g_file_new_for_uri(uri.toUtf8().constData()));
-        auto info = wrapGFileInfo(g_file_query_info(file.get()->get(),
-                                                    G_FILE_ATTRIBUTE_TRASH_ORIG_PATH,
-                                                    G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
-                                                    getCancellable().get()->get(),
-                                                    nullptr));
-        auto originPath = FileUtils::getQStringFromCString(g_file_info_get_attribute_as_string(info.get()->get(),
-                                                                              G_FILE_ATTRIBUTE_TRASH_ORIG_PATH));
+        QString originPath = index->originalPath(uri);
+        if (originPath.isNull()) {
+            //not in home trash, query the trash backend.
+            auto file = wrapGFile(g_file_new_for_uri(uri.toUtf8().constData()));
+            auto info = wrapGFileInfo(g_file_query_info(file.get()->get(),
+                                                        G_FILE_ATTRIBUTE_TRASH_ORIG_PATH,
+                                                        G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                                        getCancellable().get()->get(),
+                                                        nullptr));
+            originPath = FileUtils::getQStringFromCString(g_file_info_get_attribute_as_string(info.get()->get(),
+                                                                                 G_FILE_ATTRIBUTE_TRASH_ORIG_PATH));
+        }
 
         auto destFile = wrapGFile(g_file_new_for_path(originPath.toUtf8().constData()));
         auto originUri = FileUtils::getQStringFromCString(g_file_get_uri(destFile.get()->get()));
@@ -37,40 +77,91 @@ void FileUntrashOperation::cacheOriginalUri()
     }
 }
 
-void FileUntrashOperation::run()
+void FileUntrashOperation::untrashFile(const QString &uri)
 {
-    for (auto uri : m_uris) {
-        if (isCancelled())
-            break;
-
-        //cacheOriginalUri();
-        auto originUri = m_restore_hash.value(uri);
+    auto originUri = m_restore_hash.value(uri);
 
-        auto file = wrapGFile(g_file_new_for_uri(uri.toUtf8().constData()));        
-        auto destFile = wrapGFile(g_file_new_for_uri(originUri.toUtf8().constData()));
+    //an item in home trash is moved from the trash directory directly,
+    //so the move is a rename rather than a request to the trash backend.
+    QString trashName = TrashIndex::trashName(uri);
+    bool isHomeTrashItem = !trashName.isNull() && !TrashIndex::getInstance()->originalPath(uri).isNull();
+    QString trashPath = TrashIndex::homeTrashPath();
 
+    GFileWrapperPtr file;
+    if (isHomeTrashItem) {
+        file = wrapGFile(g_file_new_for_path(QFile::encodeName(trashPath + "/files/" + trashName).constData()));
+    } else {
+        file = wrapGFile(g_file_new_for_uri(uri.toUtf8().constData()));
+    }
+    auto destFile = wrapGFile(g_file_new_for_uri(originUri.toUtf8().constData()));
+    if (isHomeTrashItem) {
+        //the original directory might have been removed.
+        auto destParent = FileUtils::getFileParent(destFile);
+        g_file_make_directory_with_parents(destParent.get()->get(), nullptr, nullptr);
+    }
 
 retry:
-        GError *err = nullptr;
-        g_file_move(file.get()->get(),
-                    destFile.get()->get(),
-                    m_default_copy_flag,
-                    getCancellable().get()->get(),
-                    nullptr,
-                    nullptr,
-                    &err);
-
-        if (err) {
-            auto responseData = Q_EMIT errored(uri, originUri, GErrorWrapper::wrapFrom(err), true);
-            switch (responseData.value<ResponseType>()) {
-            case Retry:
-                goto retry;
-            case Cancel:
-                cancel();
-                break;
-            default:
-                break;
-            }
+    GError *err = nullptr;
+    g_file_move(file.get()->get(),
+                destFile.get()->get(),
+                m_default_copy_flag,
+                getCancellable().get()->get(),
+                nullptr,
+                nullptr,
+                &err);
+
+    if (err) {
+        if (err->code == G_IO_ERROR_CANCELLED) {
+            g_error_free(err);
+            return;
+        }
+        QMutexLocker locker(&m_error_mutex);
+        if (isCancelled()) {
+            g_error_free(err);
+            return;
         }
+        auto responseData = Q_EMIT errored(uri, originUri, GErrorWrapper::wrapFrom(err), true);
+        switch (responseData.value<ResponseType>()) {
+        case Retry:
+            locker.unlock();
+            goto retry;
+        case Cancel:
+            cancel();
+            break;
+        default:
+            break;
+        }
+    } else if (isHomeTrashItem) {
+        QFile::remove(trashPath + "/info/" + trashName + ".trashinfo");
     }
+    progress()->addCleared(uri);
+}
+
+void FileUntrashOperation::run()
+{
+    Q_EMIT operationStarted();
+
+    if (m_uris.count() >= UNTRASH_WIZARD_THRESHOLD)
+        Q_EMIT operationRequestShowWizard();
+
+    cacheOriginalUri();
+    QStringList oppositeSrcUris;
+    for (auto value : m_restore_hash) {
+        oppositeSrcUris<<value;
+    }
+    m_info = std::make_shared<FileOperationInfo>(oppositeSrcUris, "trash:///", FileOperationInfo::Trash);
+
+    //nothing to prepare, jump to the clearing stage.
+    progress()->addFound(nullptr, 0, m_uris.count());
+    Q_EMIT operationPrepared();
+    Q_EMIT operationProgressed();
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(qBound(2, QThread::idealThreadCount(), 8));
+    for (int i = 0; i < m_uris.count(); i += UNTRASH_BATCH_SIZE) {
+        pool.start(new FileUntrashJob(this, m_uris.mid(i, UNTRASH_BATCH_SIZE)));
+    }
+    pool.waitForDone();
+
+    Q_EMIT operationFinished();
 }
@@ -4,19 +4,64 @@
 #include "peony-core_global.h"
 #include "file-operation.h"
 
+#include <QMutex>
+
 namespace Peony {
 
+class FileUntrashJob;
+
+/*!
+ * \brief The FileUntrashOperation class
+ * <br>
+ * The original uris are resolved with TrashIndex in the operation thread,
+ * and the items are restored by a pool of jobs in batches. The items in home
+ * trash are moved from the trash directory directly, the others are moved
+ * by the trash backend of gio.
+ * </br>
+ * \see TrashIndex.
+ */
 class PEONYCORESHARED_EXPORT FileUntrashOperation : public FileOperation
 {
+    friend class FileUntrashJob;
     Q_OBJECT
 public:
     explicit FileUntrashOperation(QStringList uris, QObject *parent = nullptr);
 
     void run() override;
+    /*!
+     * \brief getOperationInfo
+     * \return the operation info, or null before run().
+     * \details
+     * The original uris of items are resolved in the operation thread, so
+     * the info is only valid after the operation has run.
+     */
     std::shared_ptr<FileOperationInfo> getOperationInfo() override {return m_info;}
+    /*!
+     * \brief involvedUris
+     * \return the trash uris of items.
+     * \details
+     * FileOperationManager keys a trashed item by the device which it is
+     * restored onto, so the untrash is queued with the other operations on
+     * that device.
+     */
+    QStringList involvedUris() override {return m_uris;}
 
 protected:
+    /*!
+     * \brief cacheOriginalUri
+     * <br>
+     * Resolve the original uris of items, it is called in the operation thread.
+     * </br>
+     */
     void cacheOriginalUri();
+    /*!
+     * \brief untrashFile
+     * \param uri
+     * <br>
+     * Restore an item, this is called in the untrash pool's threads.
+     * </br>
+     */
+    void untrashFile(const QString &uri);
 
 private:
     GFileCopyFlags m_default_copy_flag = GFileCopyFlags(G_FILE_COPY_NOFOLLOW_SYMLINKS|
@@ -25,6 +70,13 @@ private:
     QStringList m_uris;
     QHash<QString, QString> m_restore_hash;
     std::shared_ptr<FileOperationInfo> m_info = nullptr;
+
+    /*!
+     * \brief m_error_mutex
+     * \details
+     * The errors are handled one by one.
+     */
+    QMutex m_error_mutex;
 };
 
 }
@@ -0,0 +1,144 @@
+#include "trash-index.h"
+
+#include <QDir>
+#include <QFile>
+#include <QUrl>
+
+using namespace Peony;
+
+static TrashIndex *global_instance = nullptr;
+static QMutex global_instance_mutex;
+
+/*!
+ * \brief parseTrashInfo
+ * \return the original path in a trash info file, or null if it is invalid.
+ */
+static QString parseTrashInfo(const QString &infoPath)
+{
+    QFile file(infoPath);
+    if (!file.open(QIODevice::ReadOnly))
+        return nullptr;
+
+    QString path;
+    for (auto line : file.readAll().split('\n')) {
+        if (!line.startsWith("Path="))
+            continue;
+        char *unescaped = g_uri_unescape_string(line.mid(5).constData(), nullptr);
+        if (unescaped) {
+            path = QFile::decodeName(unescaped);
+            g_free(unescaped);
+        }
+        break;
+    }
+    return path;
+}
+
+TrashIndex *TrashIndex::getInstance()
+{
+    QMutexLocker locker(&global_instance_mutex);
+    if (!global_instance) {
+        global_instance = new TrashIndex;
+    }
+    return global_instance;
+}
+
+TrashIndex::TrashIndex(QObject *parent) : QObject(parent)
+{
+    QString infoPath = homeTrashPath() + "/info";
+    GFile *infoDir = g_file_new_for_path(infoPath.toUtf8().constData());
+    m_monitor = g_file_monitor_directory(infoDir, G_FILE_MONITOR_NONE, nullptr, nullptr);
+    g_object_unref(infoDir);
+    if (m_monitor) {
+        g_signal_connect(m_monitor, "changed", G_CALLBACK(info_dir_changed_callback), this);
+    }
+}
+
+TrashIndex::~TrashIndex()
+{
+    if (m_monitor) {
+        g_signal_handlers_disconnect_by_func(m_monitor, (gpointer)info_dir_changed_callback, this);
+        g_file_monitor_cancel(m_monitor);
+        g_object_unref(m_monitor);
+    }
+}
+
+QString TrashIndex::homeTrashPath()
+{
+    return QFile::decodeName(g_get_user_data_dir()) + "/Trash";
+}
+
+QString TrashIndex::trashName(const QString &trashUri)
+{
+    QUrl url(trashUri);
+    if (url.scheme() != "trash")
+        return nullptr;
+
+    QString name = url.path(QUrl::FullyDecoded);
+    if (name.startsWith("/"))
+        name.remove(0, 1);
+    if (name.isEmpty() || name.contains("/"))
+        return nullptr;
+    return name;
+}
+
+QString TrashIndex::originalPath(const QString &trashUri)
+{
+    QString name = trashName(trashUri);
+    if (name.isNull())
+        return nullptr;
+
+    QMutexLocker locker(&m_mutex);
+    if (!m_loaded)
+        loadIndex();
+    return m_index.value(name);
+}
+
+void TrashIndex::loadIndex()
+{
+    //the index is kept updated by monitor after loaded.
+    QDir infoDir(homeTrashPath() + "/info");
+    for (auto infoName : infoDir.entryList(QStringList()<<"*.trashinfo", QDir::Files|QDir::Hidden)) {
+        QString path = parseTrashInfo(infoDir.filePath(infoName));
+        if (!path.isNull())
+            m_index.insert(infoName.left(infoName.length() - 10), path);
+    }
+    m_loaded = true;
+}
+
+void TrashIndex::updateEntry(const QString &name)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_loaded)
+        return;
+
+    QString path = parseTrashInfo(homeTrashPath() + "/info/" + name + ".trashinfo");
+    if (path.isNull()) {
+        m_index.remove(name);
+    } else {
+        m_index.insert(name, path);
+    }
+}
+
+void TrashIndex::info_dir_changed_callback(GFileMonitor *monitor,
+                                           GFile *file,
+                                           GFile *other_file,
+                                           GFileMonitorEvent event_type,
+                                           TrashIndex *p_this)
+{
+    Q_UNUSED(monitor);
+    Q_UNUSED(other_file);
+    switch (event_type) {
+    case G_FILE_MONITOR_EVENT_CREATED:
+    case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
+    case G_FILE_MONITOR_EVENT_DELETED: {
+        char *basename = g_file_get_basename(file);
+        QString infoName = QFile::decodeName(basename);
+        g_free(basename);
+        if (infoName.endsWith(".trashinfo"))
+            p_this->updateEntry(infoName.left(infoName.length() - 10));
+        break;
+    }
+    default:
+        break;
+    }
+}
@@ -0,0 +1,82 @@
+#ifndef TRASHINDEX_H
+#define TRASHINDEX_H
+
+#include <QObject>
+#include <QHash>
+#include <QMutex>
+
+#include "peony-core_global.h"
+
+#include <gio/gio.h>
+
+namespace Peony {
+
+/*!
+ * \brief The TrashIndex class
+ * <br>
+ * TrashIndex is an in-memory index of the home trash. It parses all the
+ * .trashinfo files in ~/.local/share/Trash/info once, when it is used for
+ * the first time, and keeps itself updated by monitoring the info directory.
+ * Looking up the original path of a trashed item does not need to query
+ * the trash backend any more.
+ * </br>
+ * \note
+ * The index is thread safe, it is designed to be used by the operations running
+ * in other threads. The first lookup parses the info files, do not do that
+ * in the ui thread.
+ * Only the items in home trash are indexed. The items in the trash of other
+ * devices should be queried by gio.
+ * \see FileUntrashOperation.
+ */
+class PEONYCORESHARED_EXPORT TrashIndex : public QObject
+{
+    Q_OBJECT
+public:
+    static TrashIndex *getInstance();
+
+    static QString homeTrashPath();
+
+    /*!
+     * \brief trashName
+     * \param trashUri, a top level item in trash:///.
+     * \return the name of the item in trash's files directory, or null if it
+     * is not a top level item.
+     */
+    static QString trashName(const QString &trashUri);
+
+    /*!
+     * \brief originalPath
+     * \param trashUri, a top level item in trash:///.
+     * \return the original path of item, or null if it is not in home trash.
+     */
+    QString originalPath(const QString &trashUri);
+
+protected:
+    void loadIndex();
+    void updateEntry(const QString &name);
+
+    static void info_dir_changed_callback(GFileMonitor *monitor,
+                                          GFile *file,
+                                          GFile *other_file,
+                                          GFileMonitorEvent event_type,
+                                          TrashIndex *p_this);
+
+private:
+    explicit TrashIndex(QObject *parent = nullptr);
+    ~TrashIndex();
+
+    QMutex m_mutex;
+    bool m_loaded = false;
+    /*!
+     * \brief m_index
+     * \details
+     * The original paths keyed by the names in trash.
+     */
+    QHash<QString, QString> m_index;
+
+    GFileMonitor *m_monitor = nullptr;
+};
+
+}
+
+#endif // TRASHINDEX_H
@@ -35,7 +35,6 @@ public:
     }
 
     ~GObjectTemplate() {
-        qDebug()<<"~GObjectTemplate";
         if (m_obj)
             g_object_unref(m_obj);
     }
@@ -46,6 +45,73 @@ private:
     mutable T *m_obj = nullptr;
 };
 
+template<class T>
+/*!
+ * \brief The GObjectHandle class
+ * <br>
+ * GObjectHandle is a light weight owner of a GObject handle, like std::unique_ptr.
+ * It is move-only and has no shared control block, the handle is unrefed when the
+ * owner is destroyed. Use it in the code which creates and drops handles for every
+ * file, such as the loops of file operations, and use the GObjectTemplate wrappers
+ * for the handles shared by several objects.
+ * </br>
+ */
+class GObjectHandle
+{
+public:
+    GObjectHandle() {}
+    explicit GObjectHandle(T *obj, bool ref = false) {
+        m_obj = obj;
+        if (obj && ref) {
+            g_object_ref(obj);
+        }
+    }
+
+    GObjectHandle(GObjectHandle &&other) noexcept {
+        m_obj = other.m_obj;
+        other.m_obj = nullptr;
+    }
+
+    GObjectHandle &operator=(GObjectHandle &&other) noexcept {
+        if (this != &other)
+            reset(other.release());
+        return *this;
+    }
+
+    GObjectHandle(const GObjectHandle &) = delete;
+    GObjectHandle &operator=(const GObjectHandle &) = delete;
+
+    ~GObjectHandle() {
+        if (m_obj)
+            g_object_unref(m_obj);
+    }
+
+    T *get() const {return m_obj;}
+    explicit operator bool() const {return m_obj != nullptr;}
+
+    /*!
+     * \brief release
+     * \return the handle, the caller owns it then.
+     */
+    T *release() {
+        T *obj = m_obj;
+        m_obj = nullptr;
+        return obj;
+    }
+
+    void reset(T *obj = nullptr) {
+        if (m_obj)
+            g_object_unref(m_obj);
+        m_obj = obj;
+    }
+
+private:
+    T *m_obj = nullptr;
+};
+
+typedef GObjectHandle<GFile> GFileHandle;
+typedef GObjectHandle<GFileInfo> GFileInfoHandle;
+
 //typedef
 typedef std::shared_ptr<GObjectTemplate<GFile>> GFileWrapperPtr;
 typedef std::shared_ptr<GObjectTemplate<GFileInfo>> GFileInfoWrapperPtr;
@@ -0,0 +1,104 @@
+#include "item-job-scheduler.h"
+#include "file-info-job.h"
+#include "file-info.h"
+
+using namespace Peony;
+
+static ItemJobScheduler *global_instance = nullptr;
+
+ItemJobScheduler *ItemJobScheduler::getInstance()
+{
+    if (!global_instance) {
+        global_instance = new ItemJobScheduler;
+    }
+    return global_instance;
+}
+
+ItemJobScheduler::ItemJobScheduler(QObject *parent) : QObject(parent)
+{
+
+}
+
+void ItemJobScheduler::scheduleInfoJob(FileInfoJob *job, QObject *owner)
+{
+    PendingJob pending;
+    pending.job = job;
+    pending.owner = owner;
+    auto uri = job->getInfo()->uri();
+    m_pending_jobs.insert(uri, pending);
+    m_normal_queue.enqueue(uri);
+    startJobs();
+}
+
+ItemJobScheduler::Priority ItemJobScheduler::priority(const QString &uri)
+{
+    Priority priority = Normal;
+    for (auto viewport : m_viewports) {
+        if (viewport.visibleUris.contains(uri))
+            return Visible;
+        if (viewport.prefetchUris.contains(uri))
+            priority = Prefetch;
+    }
+    return priority;
+}
+
+void ItemJobScheduler::setViewport(QObject *view, const QStringList &visibleUris, const QStringList &prefetchUris)
+{
+    if (!m_viewports.contains(view)) {
+        connect(view, &QObject::destroyed, this, [=](){
+            m_viewports.remove(view);
+        });
+    }
+    Viewport viewport;
+    viewport.visibleUris = visibleUris;
+    viewport.prefetchUris = prefetchUris;
+    m_viewports.insert(view, viewport);
+    Q_EMIT viewportChanged(view, visibleUris, prefetchUris);
+}
+
+void ItemJobScheduler::startJobs()
+{
+    while (m_running_count < m_max_running_count) {
+        auto uri = takeNextUri();
+        if (uri.isNull())
+            return;
+
+        auto it = m_pending_jobs.find(uri);
+        auto pending = it.value();
+        m_pending_jobs.erase(it);
+        if (!pending.owner) {
+            //the item was destroyed before its job started.
+            delete pending.job;
+            continue;
+        }
+
+        m_running_count++;
+        connect(pending.job, &FileInfoJob::queryAsyncFinished, this, [=](){
+            m_running_count--;
+            this->startJobs();
+        });
+        pending.job->queryAsync();
+    }
+}
+
+const QString ItemJobScheduler::takeNextUri()
+{
+    for (auto viewport : m_viewports) {
+        for (auto uri : viewport.visibleUris) {
+            if (m_pending_jobs.contains(uri))
+                return uri;
+        }
+    }
+    for (auto viewport : m_viewports) {
+        for (auto uri : viewport.prefetchUris) {
+            if (m_pending_jobs.contains(uri))
+                return uri;
+        }
+    }
+    while (!m_normal_queue.isEmpty()) {
+        auto uri = m_normal_queue.dequeue();
+        if (m_pending_jobs.contains(uri))
+            return uri;
+    }
+    return nullptr;
+}
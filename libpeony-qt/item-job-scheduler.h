@@ -0,0 +1,115 @@
+#ifndef ITEMJOBSCHEDULER_H
+#define ITEMJOBSCHEDULER_H
+
+#include "peony-core_global.h"
+
+#include <QObject>
+#include <QMultiHash>
+#include <QHash>
+#include <QQueue>
+#include <QPointer>
+#include <QStringList>
+
+namespace Peony {
+
+class FileInfoJob;
+
+/*!
+ * \brief The ItemJobScheduler class
+ * <br>
+ * ItemJobScheduler is a single instance class shared by views, which schedules the
+ * per-item background jobs, such as querying infos of enumerated children.
+ * Without scheduling, these jobs are started in enumeration order all at once,
+ * and the items user can see might be the last ones to be updated in a huge directory.
+ * </br>
+ * <br>
+ * A view reports the uris of its visible items and a prefetch band around them
+ * with setViewport(). The viewports are kept for each view, so the views shown
+ * at the same time do not overwrite each other's. The scheduler only keeps a
+ * limited count of jobs running, and picks the next job by the priority of its
+ * uri: items visible in any view first, then the prefetch bands, then the rest
+ * in the order they were scheduled. A pending job for an item which was scrolled
+ * away falls back to the normal queue.
+ * </br>
+ * \note
+ * A pending job is bound with an owner, if the owner is destroyed before the
+ * job started, the job will be deleted without running.
+ * \see FileInfoJob, ThumbnailManager.
+ */
+class PEONYCORESHARED_EXPORT ItemJobScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    enum Priority {
+        Visible,
+        Prefetch,
+        Normal
+    };
+
+    static ItemJobScheduler *getInstance();
+
+    /*!
+     * \brief scheduleInfoJob
+     * \param job, the job will be started by FileInfoJob::queryAsync().
+     * \param owner, usually the item which handles the job's result.
+     */
+    void scheduleInfoJob(FileInfoJob *job, QObject *owner);
+
+    Priority priority(const QString &uri);
+
+    const QStringList visibleUris(QObject *view) {return m_viewports.value(view).visibleUris;}
+    const QStringList prefetchUris(QObject *view) {return m_viewports.value(view).prefetchUris;}
+
+Q_SIGNALS:
+    void viewportChanged(QObject *view, const QStringList &visibleUris, const QStringList &prefetchUris);
+
+public Q_SLOTS:
+    /*!
+     * \brief setViewport
+     * \param view, the view which reports its viewport, the viewport is removed
+     * when the view destroyed.
+     * \param visibleUris, the uris of items visible in view, sorted by their position.
+     * \param prefetchUris, the uris of items which might be visible soon.
+     */
+    void setViewport(QObject *view, const QStringList &visibleUris, const QStringList &prefetchUris);
+
+protected:
+    void startJobs();
+    /*!
+     * \brief takeNextUri
+     * \return the uri of next pending job by priority, or null if there
+     * is no pending job.
+     */
+    const QString takeNextUri();
+
+private:
+    explicit ItemJobScheduler(QObject *parent = nullptr);
+
+    struct PendingJob {
+        FileInfoJob *job = nullptr;
+        QPointer<QObject> owner;
+    };
+
+    QMultiHash<QString, PendingJob> m_pending_jobs;
+    /*!
+     * \brief m_normal_queue
+     * \details
+     * The uris of all scheduled jobs in order. An uri might has been taken
+     * by a higher priority, they are skipped when dequeued.
+     */
+    QQueue<QString> m_normal_queue;
+
+    struct Viewport {
+        QStringList visibleUris;
+        QStringList prefetchUris;
+    };
+
+    QHash<QObject*, Viewport> m_viewports;
+
+    int m_running_count = 0;
+    int m_max_running_count = 16;
+};
+
+}
+
+#endif // ITEMJOBSCHEDULER_H
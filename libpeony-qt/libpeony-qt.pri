@@ -1,6 +1,7 @@
 include(peony-core.pri)
 include(file-operation/file-operation.pri)
 include(model/model.pri)
+include(thumbnail/thumbnail.pri)
 #search vfs extension based on peony-qt core.
 include(vfs/vfs.pri)
 #plugin interface
@@ -7,6 +7,7 @@
 #include "file-copy-operation.h"
 
 #include "file-utils.h"
+#include "thumbnail-manager.h"
 
 #include <QIcon>
 #include <QMimeData>
@@ -50,7 +51,8 @@ void FileItemModel::setRootUri(const QString &uri)
 void FileItemModel::setRootItem(FileItem *item)
 {
     beginResetModel();
-    m_root_item->deleteLater();
+    if (m_root_item)
+        m_root_item->deleteLater();
 
     m_root_item = item;
     m_root_item->findChildrenAsync();
@@ -80,45 +82,35 @@ FileItem *FileItemModel::itemFromIndex(const QModelIndex &index) const
 
 QModelIndex FileItemModel::firstColumnIndex(FileItem *item)
 {
-    //root children
-    if (item->m_parent == nullptr) {
-        for (int i = 0; i < m_root_item->m_children->count(); i++) {
-            //qDebug()<<i<<item->m_info->uri()<<m_root_item->m_children->at(i)->m_info->uri();
-            if (item == m_root_item->m_children->at(i)) {
-                //qDebug()<<i<<item->m_info->uri();
-                return createIndex(i, 0, item);
-            }
-        }
-        return QModelIndex();
-    } else {
-        //has parent item
-        for (int i = 0; i < item->m_parent->m_children->count(); i++) {
-            if (item == item->m_parent->m_children->at(i))
-                return createIndex(i, 0, item);
-        }
+    int row = rowOf(item);
+    if (row < 0)
         return QModelIndex();
-    }
+    return createIndex(row, 0, item);
 }
 
 QModelIndex FileItemModel::lastColumnIndex(FileItem *item)
 {
-    if (!item->m_parent) {
-        for (int i = 0; i < m_root_item->m_children->count(); i++) {
-            //qDebug()<<i<<item->m_info->uri()<<m_root_item->m_children->at(i)->m_info->uri();
-            if (item == m_root_item->m_children->at(i)) {
-                //qDebug()<<i<<item->m_info->uri();
-                return createIndex(i, Other, item);
-            }
-        }
-        return QModelIndex();
-    } else {
-        //has parent item
-        for (int i = 0; i < item->m_parent->m_children->count(); i++) {
-            if (item == item->m_parent->m_children->at(i))
-                return createIndex(i, Other, item);
-        }
+    int row = rowOf(item);
+    if (row < 0)
         return QModelIndex();
-    }
+    return createIndex(row, Other, item);
+}
+
+int FileItemModel::rowOf(FileItem *item)
+{
+    //the root item has no row.
+    if (!item->m_parent)
+        return -1;
+
+    auto siblings = item->m_parent->m_children;
+    int hint = item->m_row_hint;
+    if (hint >= 0 && hint < siblings->count() && siblings->at(hint) == item)
+        return hint;
+
+    //the item has been moved by inserting or removing its siblings.
+    int row = siblings->indexOf(item);
+    item->m_row_hint = row;
+    return row;
 }
 
 const QModelIndex FileItemModel::indexFromUri(const QString &uri)
@@ -181,6 +173,11 @@ QVariant FileItemModel::data(const QModelIndex &index, int role) const
             /**
               \todo handle the desktop file icon
               */
+            //thumbnails are requested by views for visible items,
+            //here we only use the loaded ones and never wait for them.
+            QIcon thumbnail = ThumbnailManager::getInstance()->tryGetThumbnail(item->m_info);
+            if (!thumbnail.isNull())
+                return QVariant(thumbnail);
             QIcon icon = QIcon::fromTheme(item->m_info->iconName(), QIcon::fromTheme("text-x-generic"));
             return QVariant(icon);
         }
@@ -358,6 +355,13 @@ void FileItemModel::cancelFindChildren()
     m_root_item->cancelFindChildren();
 }
 
+void FileItemModel::revalidate()
+{
+    if (!m_root_item)
+        return;
+    m_root_item->revalidateChildren();
+}
+
 void FileItemModel::setRootIndex(const QModelIndex &index)
 {
     //NOTE: if we use proxy model, we might get the wrong item from index.
@@ -78,6 +78,17 @@ public:
      * \note Every index's internal data at same row is the same item.
      */
     QModelIndex lastColumnIndex(FileItem *item);
+    /*!
+     * \brief rowOf
+     * \param item
+     * \return the row of item in its parent, or -1 for root item.
+     * <br>
+     * The item caches its last found row, so that finding the index of an
+     * item is O(1) unless its siblings changed. Otherwise updating the items
+     * of a huge directory one by one would cost O(n^2).
+     * </br>
+     */
+    int rowOf(FileItem *item);
 
     const QModelIndex indexFromUri(const QString &uri);
 
@@ -196,6 +207,16 @@ public Q_SLOTS:
     void onItemRemoved(FileItem *item);
 
     void cancelFindChildren();
+    /*!
+     * \brief revalidate
+     * <br>
+     * Enumerate the root item's children again, and only apply the differences
+     * to model. This is used when a retained model is shown again, the current
+     * rows will be kept showing while revalidating.
+     * </br>
+     * \see FileItem::revalidateChildren().
+     */
+    void revalidate();
 
     void setRootIndex(const QModelIndex &index);
 
@@ -4,6 +4,7 @@
 #include "file-info-manager.h"
 #include "file-watcher.h"
 #include "file-utils.h"
+#include "item-job-scheduler.h"
 
 #include "file-item-model.h"
 
@@ -14,6 +15,7 @@
 
 #include <QMessageBox>
 #include <QUrl>
+#include <QSet>
 
 using namespace Peony;
 
@@ -108,9 +110,13 @@ void FileItem::findChildrenAsync()
                     Q_EMIT m_model->findChildrenFinished();
                 }
 
+                //the rows are sorted by proxy model, append is enough and
+                //avoid moving all the children for every new child.
+                m_children->reserve(infos.count());
                 for (auto info : infos) {
                     FileItem *child = new FileItem(info, this, m_model);
-                    m_children->prepend(child);
+                    child->m_row_hint = m_children->count();
+                    m_children->append(child);
                     FileInfoJob *job = new FileInfoJob(info);
                     job->setAutoDelete();
                     /*
@@ -121,7 +127,7 @@ void FileItem::findChildrenAsync()
                         qDebug()<<shared_info->iconName()<<row;
                     });
                     */
-                    connect(job, &FileInfoJob::infoUpdated, [=](){
+                    connect(job, &FileInfoJob::infoUpdated, this, [=](){
                         //the query job is finished and will be deleted soon,
                         //whatever info was updated, we need decrease the async count.
                         m_async_count--;
@@ -131,7 +137,7 @@ void FileItem::findChildrenAsync()
                             Q_EMIT m_model->updated();
                         }
                     });
-                    job->queryAsync();
+                    ItemJobScheduler::getInstance()->scheduleInfoJob(job, this);
                 }
             } else {
                 Q_EMIT m_model->findChildrenFinished();
@@ -188,16 +194,18 @@ void FileItem::findChildrenAsync()
             for (auto uri : uris) {
                 auto info = FileInfo::fromUri(uri);
                 auto item = new FileItem(info, this, m_model);
+                item->m_row_hint = m_children->count();
                 m_children->append(item);
                 m_model->insertRows(m_children->count() - 2, 1, firstColumnIndex());
 
                 auto infoJob = new FileInfoJob(info);
                 infoJob->setAutoDelete();
-                infoJob->connect(infoJob, &FileInfoJob::infoUpdated, [=](){
+                infoJob->connect(infoJob, &FileInfoJob::infoUpdated, item, [=](){
                     Q_EMIT m_model->dataChanged(item->firstColumnIndex(), item->lastColumnIndex());
                     //Q_EMIT m_model->updated();
                 });
-                infoJob->queryAsync();
+                //let the visible items be queried first.
+                ItemJobScheduler::getInstance()->scheduleInfoJob(infoJob, item);
             }
         });
 
@@ -242,6 +250,55 @@ void FileItem::findChildrenAsync()
     enumerator->prepare();
 }
 
+void FileItem::revalidateChildren()
+{
+    if (!m_expanded) {
+        findChildrenAsync();
+        return;
+    }
+
+    Peony::FileEnumerator *enumerator = new Peony::FileEnumerator;
+    enumerator->setEnumerateDirectory(m_info->uri());
+    enumerator->connect(this, &FileItem::cancelFindChildren, enumerator, &FileEnumerator::cancel);
+    enumerator->connect(enumerator, &FileEnumerator::prepared, [=](std::shared_ptr<GErrorWrapper> err){
+        if (err) {
+            //keep the current children, the watcher will handle
+            //the deleted or unmounted directory.
+            qDebug()<<err->message();
+            enumerator->cancel();
+            enumerator->deleteLater();
+            return;
+        }
+        enumerator->enumerateAsync();
+    });
+    enumerator->connect(enumerator, &Peony::FileEnumerator::enumerateFinished, this, [=](bool successed){
+        if (successed) {
+            QSet<QString> currentUris;
+            for (auto child : *m_children) {
+                currentUris<<child->uri();
+            }
+
+            QSet<QString> newUris;
+            for (auto info : enumerator->getChildren()) {
+                newUris<<info->uri();
+            }
+
+            for (auto uri : currentUris - newUris) {
+                this->onChildRemoved(uri);
+            }
+            for (auto uri : newUris - currentUris) {
+                this->onChildAdded(uri);
+            }
+        }
+        enumerator->cancel();
+        enumerator->deleteLater();
+        Q_EMIT m_model->findChildrenFinished();
+        Q_EMIT m_model->updated();
+    });
+
+    enumerator->prepare();
+}
+
 QModelIndex FileItem::firstColumnIndex()
 {
     return m_model->firstColumnIndex(this);
@@ -278,6 +335,7 @@ void FileItem::onChildAdded(const QString &uri)
         return;
     }
     FileItem *newChild = new FileItem(FileInfo::fromUri(uri), this, m_model);
+    newChild->m_row_hint = m_children->count();
     m_children->append(newChild);
     m_model->insertRow(m_children->count() - 1, this->firstColumnIndex());
     //use sync update here.
@@ -358,7 +416,7 @@ void FileItem::updateInfoAsync()
 {
     FileInfoJob *job = new FileInfoJob(m_info);
     job->setAutoDelete();
-    job->connect(job, &FileInfoJob::infoUpdated, [=](){
+    job->connect(job, &FileInfoJob::infoUpdated, this, [=](){
         m_model->dataChanged(this->firstColumnIndex(), this->lastColumnIndex());
     });
     job->queryAsync();
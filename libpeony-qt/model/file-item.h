@@ -51,6 +51,17 @@ public:
 
     QVector<FileItem*> *findChildrenSync();
     void findChildrenAsync();
+    /*!
+     * \brief revalidateChildren
+     * <br>
+     * Enumerate the children asynchronously again, and add or remove the
+     * children which are different from the current ones. Unlike clearing
+     * and finding children again, the unchanged children are kept, so the
+     * view can still show them while revalidating.
+     * </br>
+     * \note If the item has not been expanded, this is same as findChildrenAsync().
+     */
+    void revalidateChildren();
 
     /*!
      * \brief firstColumnIndex
@@ -122,6 +133,12 @@ private:
 
     bool m_expanded = false;
 
+    /*!
+     * \brief m_row_hint
+     * \see FileItemModel::rowOf().
+     */
+    int m_row_hint = -1;
+
     FileWatcher *m_watcher = nullptr;
 
     /*!
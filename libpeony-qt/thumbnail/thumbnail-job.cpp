@@ -0,0 +1,146 @@
+#include "thumbnail-job.h"
+#include "thumbnail-manager.h"
+
+#include <QCryptographicHash>
+#include <QStandardPaths>
+#include <QImageReader>
+#include <QSaveFile>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QMetaObject>
+
+#include <gio/gio.h>
+
+using namespace Peony;
+
+ThumbnailJob::ThumbnailJob(const QString &uri, ThumbnailManager *manager)
+{
+    m_uri = uri;
+    m_manager = manager;
+    setAutoDelete(false);
+}
+
+QString ThumbnailJob::thumbnailPath(const QString &canonicalUri, int size)
+{
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + "/thumbnails/";
+    dir += size > ThumbnailManager::Normal? "large": "normal";
+    QByteArray md5 = QCryptographicHash::hash(canonicalUri.toUtf8(), QCryptographicHash::Md5).toHex();
+    return dir + "/" + md5 + ".png";
+}
+
+void ThumbnailJob::run()
+{
+    if (isCancelled()) {
+        QMetaObject::invokeMethod(m_manager, "onJobFinished", Qt::QueuedConnection,
+                                  Q_ARG(QString, m_uri),
+                                  Q_ARG(QImage, QImage()),
+                                  Q_ARG(quint64, 0),
+                                  Q_ARG(bool, true));
+        return;
+    }
+
+    GFile *file = g_file_new_for_uri(m_uri.toUtf8().constData());
+    GFileInfo *info = g_file_query_info(file,
+                                        G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE ","
+                                        G_FILE_ATTRIBUTE_TIME_MODIFIED,
+                                        G_FILE_QUERY_INFO_NONE,
+                                        nullptr,
+                                        nullptr);
+    QImage image;
+    quint64 mtime = 0;
+    if (info) {
+        mtime = g_file_info_get_attribute_uint64(info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+        char *canonical_uri = g_file_get_uri(file);
+        QString canonicalUri = canonical_uri;
+        g_free(canonical_uri);
+
+        image = lookupCachedThumbnail(canonicalUri, mtime);
+        if (image.isNull()) {
+            //only local image files are generated by ourselves, other thumbnails
+            //might be generated by other thumbnailers.
+            QString contentType = g_file_info_get_content_type(info);
+            char *path = g_file_get_path(file);
+            if (path && contentType.startsWith("image/")) {
+                image = generateThumbnail(path, canonicalUri, mtime);
+            }
+            g_free(path);
+        }
+        g_object_unref(info);
+    }
+    g_object_unref(file);
+
+    QMetaObject::invokeMethod(m_manager, "onJobFinished", Qt::QueuedConnection,
+                              Q_ARG(QString, m_uri),
+                              Q_ARG(QImage, image),
+                              Q_ARG(quint64, mtime),
+                              Q_ARG(bool, false));
+}
+
+QImage ThumbnailJob::lookupCachedThumbnail(const QString &canonicalUri, quint64 mtime)
+{
+    QList<int> sizes;
+    sizes<<ThumbnailManager::Normal<<ThumbnailManager::Large;
+    for (auto size : sizes) {
+        QImageReader reader(thumbnailPath(canonicalUri, size));
+        if (!reader.canRead())
+            continue;
+        //a thumbnail is out of date if the file was modified after it created.
+        if (reader.text("Thumb::MTime") != QString::number(mtime))
+            continue;
+
+        QSize thumbnailSize = reader.size();
+        if (thumbnailSize.width() > ThumbnailManager::Normal || thumbnailSize.height() > ThumbnailManager::Normal) {
+            reader.setScaledSize(thumbnailSize.scaled(ThumbnailManager::Normal, ThumbnailManager::Normal, Qt::KeepAspectRatio));
+        }
+        QImage image = reader.read();
+        if (!image.isNull())
+            return image;
+    }
+    return QImage();
+}
+
+QImage ThumbnailJob::generateThumbnail(const QString &path, const QString &canonicalUri, quint64 mtime)
+{
+    QImageReader reader(path);
+    reader.setAutoTransform(true);
+    if (!reader.canRead())
+        return QImage();
+
+    QSize imageSize = reader.size();
+    bool needScale = imageSize.width() > ThumbnailManager::Normal || imageSize.height() > ThumbnailManager::Normal;
+    if (needScale) {
+        reader.setScaledSize(imageSize.scaled(ThumbnailManager::Normal, ThumbnailManager::Normal, Qt::KeepAspectRatio));
+    }
+    QImage image = reader.read();
+    if (image.isNull() || !needScale)
+        return image;
+
+    //do not create thumbnails for the thumbnails in cache directory.
+    QString normalPath = thumbnailPath(canonicalUri, ThumbnailManager::Normal);
+    QString cacheDir = QFileInfo(normalPath).absolutePath();
+    QString thumbnailsDir = QFileInfo(cacheDir).absolutePath();
+    if (path.startsWith(thumbnailsDir))
+        return image;
+
+    if (!QDir().mkpath(cacheDir))
+        return image;
+    QFile::setPermissions(cacheDir, QFile::ReadOwner|QFile::WriteOwner|QFile::ExeOwner);
+
+    image.setText("Thumb::URI", canonicalUri);
+    image.setText("Thumb::MTime", QString::number(mtime));
+    image.setText("Software", "peony-qt");
+
+    //QSaveFile writes a temporary file and renames it, so that other
+    //thumbnail readers will never read a partial png.
+    QSaveFile saveFile(normalPath);
+    if (saveFile.open(QIODevice::WriteOnly)) {
+        saveFile.setPermissions(QFile::ReadOwner|QFile::WriteOwner);
+        if (image.save(&saveFile, "PNG")) {
+            saveFile.commit();
+        } else {
+            saveFile.cancelWriting();
+        }
+    }
+    return image;
+}
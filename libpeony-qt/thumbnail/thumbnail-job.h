@@ -0,0 +1,71 @@
+#ifndef THUMBNAILJOB_H
+#define THUMBNAILJOB_H
+
+#include "peony-core_global.h"
+
+#include <QRunnable>
+#include <QString>
+#include <QImage>
+#include <QAtomicInt>
+
+namespace Peony {
+
+class ThumbnailManager;
+
+/*!
+ * \brief The ThumbnailJob class
+ * <br>
+ * ThumbnailJob is a runnable which looks up or generates the thumbnail of a file
+ * in a worker thread of ThumbnailManager's pool. It follows the freedesktop
+ * thumbnail managing standard. The job will look up the normal and large
+ * thumbnail cache directory first, a cached thumbnail is valid only if its
+ * Thumb::MTime is equal to the file's modified time.
+ * If there is not a valid cached thumbnail, the job will try generating one
+ * for local image files, and save it into the normal cache directory.
+ * </br>
+ * \note
+ * A job is owned by ThumbnailManager, it does not delete itself when finished.
+ * The result is sent back to manager by a queued invocation.
+ * \see ThumbnailManager.
+ */
+class PEONYCORESHARED_EXPORT ThumbnailJob : public QRunnable
+{
+public:
+    explicit ThumbnailJob(const QString &uri, ThumbnailManager *manager);
+
+    const QString uri() {return m_uri;}
+
+    /*!
+     * \brief cancel
+     * <br>
+     * Cancel a job which might be running. A running job will only check
+     * this state before it starts the real work.
+     * </br>
+     */
+    void cancel() {m_cancelled.store(1);}
+    void resume() {m_cancelled.store(0);}
+    bool isCancelled() {return m_cancelled.load() != 0;}
+
+    void run() override;
+
+    /*!
+     * \brief thumbnailPath
+     * \param canonicalUri, escaped uri of file, such as g_file_get_uri() returns.
+     * \param size, 128 for normal and 256 for large.
+     * \return the path of thumbnail in freedesktop thumbnail cache directory.
+     */
+    static QString thumbnailPath(const QString &canonicalUri, int size);
+
+protected:
+    QImage lookupCachedThumbnail(const QString &canonicalUri, quint64 mtime);
+    QImage generateThumbnail(const QString &path, const QString &canonicalUri, quint64 mtime);
+
+private:
+    QString m_uri;
+    ThumbnailManager *m_manager = nullptr;
+    QAtomicInt m_cancelled;
+};
+
+}
+
+#endif // THUMBNAILJOB_H
@@ -0,0 +1,172 @@
+#include "thumbnail-manager.h"
+#include "thumbnail-job.h"
+#include "file-info.h"
+
+#include <QPixmap>
+#include <QThread>
+
+using namespace Peony;
+
+static ThumbnailManager *global_instance = nullptr;
+
+ThumbnailManager *ThumbnailManager::getInstance()
+{
+    if (!global_instance) {
+        global_instance = new ThumbnailManager;
+    }
+    return global_instance;
+}
+
+ThumbnailManager::ThumbnailManager(QObject *parent) : QObject(parent)
+{
+    //decoding images is cpu bound, but we should not take all the cores
+    //from other works, such as file operations.
+    m_pool.setMaxThreadCount(qBound(1, QThread::idealThreadCount()/2, 4));
+    //64 MiB
+    m_cache.setMaxCost(64*1024);
+    //a failed file costs 1.
+    m_failed_uris.setMaxCost(4096);
+}
+
+ThumbnailManager::~ThumbnailManager()
+{
+    cancelAll();
+    m_pool.waitForDone();
+    for (auto job : m_jobs) {
+        delete job;
+    }
+    m_jobs.clear();
+}
+
+QIcon ThumbnailManager::tryGetThumbnail(const std::shared_ptr<FileInfo> &info)
+{
+    auto uri = info->uri();
+    auto failedMtime = m_failed_uris.object(uri);
+    if (failedMtime && *failedMtime != info->modifiedTime()) {
+        m_failed_uris.remove(uri);
+    }
+
+    auto thumbnail = m_cache.object(uri);
+    if (!thumbnail)
+        return QIcon();
+
+    //the info might not be queried yet.
+    if (info->modifiedTime() != 0 && thumbnail->mtime != info->modifiedTime()) {
+        m_cache.remove(uri);
+        return QIcon();
+    }
+    return thumbnail->icon;
+}
+
+void ThumbnailManager::requestThumbnails(QObject *view, const QStringList &uris)
+{
+    if (!m_requests.contains(view)) {
+        connect(view, &QObject::destroyed, this, &ThumbnailManager::onViewDestroyed);
+    }
+
+    QSet<QString> requested;
+    int priority = uris.count();
+    for (auto uri : uris) {
+        priority--;
+        if (requested.contains(uri) || m_cache.contains(uri) || m_failed_uris.contains(uri))
+            continue;
+        requested<<uri;
+
+        auto job = m_jobs.value(uri);
+        if (job) {
+            //the job is pending or running, reorder it if it is still in queue.
+            job->resume();
+            if (m_pool.tryTake(job)) {
+                m_pool.start(job, priority);
+            }
+            m_priorities.insert(uri, priority);
+            continue;
+        }
+
+        job = new ThumbnailJob(uri, this);
+        m_jobs.insert(uri, job);
+        m_priorities.insert(uri, priority);
+        m_pool.start(job, priority);
+    }
+
+    //cancel the previous requests of view.
+    m_requests.insert(view, requested);
+    cancelUnrequestedJobs();
+}
+
+void ThumbnailManager::onViewDestroyed(QObject *view)
+{
+    m_requests.remove(view);
+    cancelUnrequestedJobs();
+}
+
+void ThumbnailManager::cancelUnrequestedJobs()
+{
+    QSet<QString> requested;
+    for (auto uris : m_requests) {
+        requested.unite(uris);
+    }
+
+    for (auto uri : m_jobs.keys()) {
+        if (requested.contains(uri))
+            continue;
+        auto job = m_jobs.value(uri);
+        if (m_pool.tryTake(job)) {
+            m_jobs.remove(uri);
+            m_priorities.remove(uri);
+            delete job;
+        } else {
+            job->cancel();
+        }
+    }
+}
+
+void ThumbnailManager::cancelAll()
+{
+    for (auto uri : m_jobs.keys()) {
+        auto job = m_jobs.value(uri);
+        if (m_pool.tryTake(job)) {
+            m_jobs.remove(uri);
+            m_priorities.remove(uri);
+            delete job;
+        } else {
+            job->cancel();
+        }
+    }
+}
+
+void ThumbnailManager::onJobFinished(const QString &uri, const QImage &image, quint64 mtime, bool cancelled)
+{
+    auto job = m_jobs.value(uri);
+    if (!job)
+        return;
+
+    if (cancelled) {
+        //the job might be requested again after it gave up.
+        if (!job->isCancelled()) {
+            m_pool.start(job, m_priorities.value(uri));
+            return;
+        }
+        m_jobs.remove(uri);
+        m_priorities.remove(uri);
+        delete job;
+        return;
+    }
+
+    m_jobs.remove(uri);
+    m_priorities.remove(uri);
+    delete job;
+
+    if (image.isNull()) {
+        m_failed_uris.insert(uri, new quint64(mtime));
+        return;
+    }
+
+    auto thumbnail = new Thumbnail;
+    thumbnail->icon = QIcon(QPixmap::fromImage(image));
+    thumbnail->mtime = mtime;
+    int cost = qMax(1, image.width()*image.height()*4/1024);
+    m_cache.insert(uri, thumbnail, cost);
+
+    Q_EMIT thumbnailUpdated(uri);
+}
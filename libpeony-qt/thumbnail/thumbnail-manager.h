@@ -0,0 +1,130 @@
+#ifndef THUMBNAILMANAGER_H
+#define THUMBNAILMANAGER_H
+
+#include "peony-core_global.h"
+
+#include <QObject>
+#include <QThreadPool>
+#include <QCache>
+#include <QHash>
+#include <QSet>
+#include <QIcon>
+#include <QImage>
+
+#include <memory>
+
+namespace Peony {
+
+class FileInfo;
+class ThumbnailJob;
+
+/*!
+ * \brief The ThumbnailManager class
+ * <br>
+ * ThumbnailManager is a single instance class which provides the thumbnails of
+ * files for views. The thumbnails are looked up or generated by ThumbnailJob
+ * in a bounded thread pool, and cached in memory once they are loaded.
+ * A view should never wait for a thumbnail when painting. It should use
+ * tryGetThumbnail() for an available thumbnail, and request the thumbnails
+ * of its visible items with requestThumbnails(). When a thumbnail is
+ * loaded, thumbnailUpdated() signal will be sent, and the view should repaint
+ * the corresponding item.
+ * </br>
+ * \note
+ * Requesting thumbnails will cancel the previous requests of the same view
+ * which have not been started and not requested again. So a view should always
+ * request the thumbnails of all the items it is showing. The requests of a view
+ * do not cancel the others', and they are dropped when the view destroyed.
+ * \see ThumbnailJob.
+ */
+class PEONYCORESHARED_EXPORT ThumbnailManager : public QObject
+{
+    friend class ThumbnailJob;
+    Q_OBJECT
+public:
+    enum Size {
+        Normal = 128,
+        Large = 256
+    };
+
+    static ThumbnailManager *getInstance();
+
+    /*!
+     * \brief tryGetThumbnail
+     * \param info
+     * \return the thumbnail of file which has been loaded into memory,
+     * or a null icon if it is not available now.
+     * \note This method is cheap, it can be called in painting.
+     */
+    QIcon tryGetThumbnail(const std::shared_ptr<FileInfo> &info);
+
+    /*!
+     * \brief requestThumbnails
+     * \param view, the requester of thumbnails.
+     * \param uris, the uris of files need thumbnail, sorted by priority.
+     * <br>
+     * The former uris will be handled first. The pending requests of view
+     * which are not in uris will be cancelled, unless another view requests
+     * them too.
+     * </br>
+     */
+    void requestThumbnails(QObject *view, const QStringList &uris);
+
+    void cancelAll();
+
+Q_SIGNALS:
+    void thumbnailUpdated(const QString &uri);
+
+private Q_SLOTS:
+    void onViewDestroyed(QObject *view);
+    void onJobFinished(const QString &uri, const QImage &image, quint64 mtime, bool cancelled);
+
+private:
+    explicit ThumbnailManager(QObject *parent = nullptr);
+    ~ThumbnailManager() override;
+
+    /*!
+     * \brief cancelUnrequestedJobs
+     * <br>
+     * Cancel the jobs which are not requested by any view.
+     * </br>
+     */
+    void cancelUnrequestedJobs();
+
+    struct Thumbnail {
+        QIcon icon;
+        quint64 mtime = 0;
+    };
+
+    QThreadPool m_pool;
+
+    /*!
+     * \brief m_cache
+     * \details
+     * The cost of a thumbnail is its size in KiB.
+     */
+    QCache<QString, Thumbnail> m_cache;
+
+    QHash<QString, ThumbnailJob*> m_jobs;
+    QHash<QString, int> m_priorities;
+
+    /*!
+     * \brief m_requests
+     * \details
+     * The uris requested by every view.
+     */
+    QHash<QObject*, QSet<QString>> m_requests;
+
+    /*!
+     * \brief m_failed_uris
+     * \details
+     * The modified time of files which could not be thumbnailed, they should not
+     * be requested again until their modified time changed. The least recently
+     * used ones are evicted, so it does not grow over a long session.
+     */
+    QCache<QString, quint64> m_failed_uris;
+};
+
+}
+
+#endif // THUMBNAILMANAGER_H
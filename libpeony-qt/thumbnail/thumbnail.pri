@@ -0,0 +1,9 @@
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/thumbnail-manager.h \
+    $$PWD/thumbnail-job.h
+
+SOURCES += \
+    $$PWD/thumbnail-manager.cpp \
+    $$PWD/thumbnail-job.cpp